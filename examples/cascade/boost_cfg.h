@@ -49,6 +49,17 @@ typedef double constant;
 /// 训练时级联分类器的滑动窗口移动步长（像素）
 #define DETECTOR_DELTA 2
 
+/// 训练时挖掘难负样本的检测线程数；大于 1 时另有一个线程负责获取非人脸图片，
+/// 为 1 时在调用者线程中依次获取、检测
+#define MINE_THREADS 4
+
+/// 定义时训练样本存放于映射到临时文件的存储区（样本集可大于物理内存），值为临时
+/// 文件名前缀；未定义时样本存放于堆内存
+// #define SAMPLE_STORE "./cas_samples"
+
+/// 样本存放于文件时，顺序访问的常驻内存预算（字节）
+#define SAMPLE_STORE_BUDGET (1UL << 30)
+
 /*******************************************************************************
  * 				    全局配置
  ******************************************************************************/
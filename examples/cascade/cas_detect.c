@@ -3,6 +3,7 @@
 #include <string.h>
 #include "cascade.h"
 #include "image.h"
+#include "cas_profile.h"
 
 // 文件名最大长度
 #define MAX_FILENAME 128
@@ -14,6 +15,12 @@
 #define MARKPATH "./p_mark"
 // 模型保存路径
 #define MODEL_PATH "./cascade_data"
+// 性能统计的输出路径
+#define PROFILE_PATH "./cas_profile.json"
+// 每批检测的图片数量
+#define BATCH_SIZE 64
+// 并行检测的线程数
+#define DETECT_THREADS 4
 
 static void rect_print(struct cascade *pcascade, const char *fname,
 		       const struct haar_ada_handles *handles);
@@ -28,9 +35,16 @@ int main (void)
 
 	struct cascade cascade;
 	struct haar_ada_handles handles;
-	ada_set_haar (&handles, ADA_ASYM_IMP, ADA_GA);
+	ada_set_haar (&handles, ADA_ASYM_IMP, ADA_GA, NULL);
 	cas_read (&cascade, model_file, &handles);
 	rect_print (&cascade, MARKPATH, &handles);
+#ifdef CAS_PROFILE
+	FILE *prof_file = fopen(PROFILE_PATH, "w");
+	if (prof_file != NULL) {
+		cas_profile_dump(prof_file);
+		fclose(prof_file);
+	}
+#endif
 
 	cas_free (&cascade, &handles);
 	fclose (model_file);
@@ -49,33 +63,48 @@ void rect_print(struct cascade *pcascade, const char *fname,
 		exit(EXIT_FAILURE);
 	}
 
-	struct image *img;
-	struct cas_det_rect *prect;
-	link_iter iter;
-	struct link_list rect_list;
+	char names[BATCH_SIZE][MAX_FILENAME];
+	struct image *img[BATCH_SIZE];
+	struct cas_batch_image batch[BATCH_SIZE];
+	struct cas_det_array res[BATCH_SIZE];
+	struct cas_det_param param;
+	int n, i;
+	cas_det_param_default(&param);
+	param.delta = 3;
+	param.threads = DETECT_THREADS;
 	// 跳过训练集部分
-	for (int i = 0; i < TRAIN_COUNT; ++i)
+	for (i = 0; i < TRAIN_COUNT; ++i)
 		fscanf(mark, "%*s %*d %*d %*d %*d");
-	// 在测试集上进行检测
-	while (fscanf(mark, "%s %*d %*d %*d %*d", ptr_file) == 1) {
-		if ((img = imread_pgm(filename)) == NULL) {
-			perror("Can't open image.\n");
+	// 在测试集上分批检测
+	do {
+		for (n = 0; n < BATCH_SIZE
+		     && fscanf(mark, "%s %*d %*d %*d %*d", ptr_file) == 1; ++n) {
+			if ((img[n] = imread_pgm(filename)) == NULL) {
+				perror("Can't open image.\n");
+				fclose(mark);
+				exit(EXIT_FAILURE);
+			}
+			strcpy(names[n], ptr_file);
+			batch[n] = (struct cas_batch_image) {
+				img[n]->height, img[n]->width, img[n]->img
+			};
+		}
+		if (!cas_detect_batch(pcascade, n, batch, &param, handles,
+				      res)) {
+			fprintf(stderr, "Detection failed.\n");
 			fclose(mark);
 			exit(EXIT_FAILURE);
 		}
-		rect_list = cas_detect(pcascade, img->height, img->width,
-				       (void *)img->img, 3, handles);
-		iter = link_list_start_iter(&rect_list);
-		printf("file: %s\n", ptr_file);
-		while (link_list_check_end(iter)) {
-			prect = link_list_get_data(iter);
-			printf("x: %4d \t y: %4d \t len: %4d\n",
-			       prect->rect.start_x, prect->rect.start_y,
-			       prect->rect.len);
-			link_list_next_iter(&iter);
+		for (i = 0; i < n; ++i) {
+			printf("file: %s\n", names[i]);
+			for (size_t k = 0; k < res[i].size; ++k)
+				printf("x: %4d \t y: %4d \t len: %4d\n",
+				       res[i].rect[k].rect.start_x,
+				       res[i].rect[k].rect.start_y,
+				       res[i].rect[k].rect.len);
+			cas_det_array_free(&res[i]);
+			free(img[i]);
 		}
-		free(img);
-		link_list_free_full(&rect_list, free);
-	}
+	} while (n == BATCH_SIZE);
 	fclose(mark);
 }
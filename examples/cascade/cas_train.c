@@ -27,6 +27,8 @@
 #define N_NUM 100000
 // 模型保存路径
 #define MODEL_PATH "./cascade_data"
+// 训练检查点路径：训练中断后重新运行即从检查点恢复，训练完成后删除
+#define CKPT_PATH "./cascade_ckpt"
 
 /*******************************************************************************
  * 				    类型定义
@@ -77,13 +79,18 @@ int main(void)
 	struct sp_args args;
 	struct cascade cascade;
 	struct haar_ada_handles handles;
+	struct wl_ga_param ga_param;
 	if (!init_args (&args, MARKPATH))
 		exit(EXIT_FAILURE);
 
-	ada_set_haar (&handles, ADA_ASYM_IMP, ADA_GA);
-	if (!cas_train (&cascade, DET_RATE, FP_RATE, MAX_FP_RATE,
-			TRAIN_SET_PERCENT, P_NUM, N_NUM, FACE_SIZE, &args,
-			get_face, get_non_face, &handles)) {
+	// 各轮、各级训练共享精英个体档案，热启动进化算法
+	wl_ga_param_default (&ga_param);
+	ga_param.archive = wl_ga_archive_new (POP_SIZE);
+	ada_set_haar (&handles, ADA_ASYM_IMP, ADA_GA, &ga_param);
+	if (!cas_train_resume (&cascade, CKPT_PATH, DET_RATE, FP_RATE,
+			       MAX_FP_RATE, TRAIN_SET_PERCENT, P_NUM, N_NUM,
+			       FACE_SIZE, &args, get_face, get_non_face,
+			       &handles)) {
 		fprintf(stderr, "Training Error.\n");
 		goto train_err;
 	}
@@ -91,11 +98,14 @@ int main(void)
 	FILE * file = fopen (MODEL_PATH, "wb");
 	cas_write (&cascade, file, &handles);
 	fclose (file);
+	remove (CKPT_PATH);
 	cas_free (&cascade, &handles);
+	wl_ga_archive_free (ga_param.archive);
 	free_args (&args);
 	return 0;
 
 train_err:
+	wl_ga_archive_free (ga_param.archive);
 	free_args (&args);
 	exit(EXIT_FAILURE);
 }
@@ -17,7 +17,8 @@ label_t constant_h(const void *model, const sample_t x[], dim_t n)
 }
 
 bool constant_train(void *model, num_t m, dim_t n, const sample_t X[m][n],
-		    const label_t Y[], const flt_t D[], const void *cache)
+		    const label_t Y[], const flt_t D[], const void *cache,
+		    struct train_ctx *ctx)
 {
 	constant *c = (constant *) model;
 	*c = 0;
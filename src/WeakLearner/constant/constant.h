@@ -10,6 +10,7 @@
 
 #include <stdbool.h>
 #include "boost_cfg.h"
+#include "train_ctx.h"
 
 /*******************************************************************************
  * 				    函数声明
@@ -35,10 +36,12 @@ label_t constant_h(const void *model, const sample_t x[], dim_t n);
  * \param[in] Y         样本标签数组，每个元素对应一个样本的正确分类
  * \param[in] D         样本概率分布数组
  * \param[in] cache      缓存指针，此处被忽略
+ * \param[in] ctx        训练上下文，此处被忽略
  *
  * \return 
  */
 bool constant_train(void *model, num_t m, dim_t n, const sample_t X[m][n],
-		    const label_t Y[], const flt_t D[], const void *cache);
+		    const label_t Y[], const flt_t D[], const void *cache,
+		    struct train_ctx *ctx);
 
 #endif
@@ -3,6 +3,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include "../weaklearner.h"
+#include "stump_screen_base.h"
 #include "haar_stump.h"
 #include "haar_stump_pvt.h"
 
@@ -20,22 +22,39 @@
  * \brief 训练模板
  * \param[in] stump_type 即 stump 实际上的类型
  * \param[in] fun_opt    基类选择最优划分属性函数的函数名，如 cstump_opt、cstump_cf_opt
+ * \param[in] fun_screen 基类两阶段寻优函数的函数名，如 cstump_screen_opt
  * \details \copydetails haar_stump_train()
  */
-#define TRAIN(stump, m, h, w, X, X2, Y, D, stump_type, fun_opt)			\
+#define TRAIN(stump, m, h, w, X, X2, Y, D, param, ctx, stump_type, fun_opt,	\
+	      fun_screen)							\
 ({										\
  	bool status;								\
 	do {									\
 		stump_type ptr = stump;						\
 		struct sp_wrap sp;						\
 		struct stump_opt_handles handles;				\
-		if (!init_train (&sp, &handles, X, X2, m, h, w)) {		\
+		if (!init_train (&sp, &handles, X, X2, m, h, w, ctx)) {	\
 			status = false;						\
  			break;							\
 		}								\
-		status = fun_opt (&ptr->base, &ptr->feature,			\
-				sizeof(struct haar_feature), m, &sp, Y, D,	\
-				&handles);					\
+		const struct wl_opt_param *opt_param = param;			\
+		if (opt_param == NULL || opt_param->top_k == 0			\
+		    || opt_param->sub_m >= m) {					\
+			status = fun_opt (&ptr->base, &ptr->feature,		\
+					sizeof(struct haar_feature), m, &sp,	\
+					Y, D, &handles);			\
+			free_train (&sp);					\
+			break;							\
+		}								\
+		struct sp_wrap sub;						\
+		struct stump_screen screen;					\
+		status = init_screen (&sub, &screen, opt_param, &sp, m, Y, D);	\
+		if (status) {							\
+			status = fun_screen (&ptr->base, &ptr->feature,		\
+					sizeof(struct haar_feature), m, &sp,	\
+					Y, D, &handles, &screen);		\
+			free_screen (&sub, &screen);				\
+		}								\
 		free_train (&sp);						\
 	} while (0);								\
 	status;									\
@@ -53,11 +72,12 @@
  * \param[in] m        样本数量
  * \param[in] h        训练图像高度
  * \param[in] w        训练图像宽度
+ * \param[in] ctx      训练上下文
  * \return 成功则返回真，失败则返回假
  */
 static bool init_train(struct sp_wrap *sp, struct stump_opt_handles *handles,
 		       const sample_t * const *X, const sample_t * const *X2,
-		       num_t m, imgsz_t h, imgsz_t w);
+		       num_t m, imgsz_t h, imgsz_t w, struct train_ctx *ctx);
 
 /**
  * \brief 训练资源释放操作
@@ -65,6 +85,30 @@ static bool init_train(struct sp_wrap *sp, struct stump_opt_handles *handles,
  */
 static inline void free_train(struct sp_wrap *sp);
 
+/**
+ * \brief 两阶段寻优的初始化操作：按样本概率分布进行系统重采样，构造子样本集
+ *      （子样本为原样本的引用，各子样本的概率相等）
+ * \param[out] sub    指向未初始化的子样本集
+ * \param[out] screen 指向未初始化的两阶段寻优设置
+ * \param[in] param   枚举训练参数
+ * \param[in] sp      已初始化的完整样本集
+ * \param[in] m       样本数量
+ * \param[in] Y       样本标签
+ * \param[in] D       样本概率分布
+ * \return 成功则返回真，否则返回假
+ */
+static bool init_screen(struct sp_wrap *sub, struct stump_screen *screen,
+			const struct wl_opt_param *param,
+			const struct sp_wrap *sp, num_t m, const label_t Y[],
+			const flt_t D[]);
+
+/**
+ * \brief 两阶段寻优资源释放操作
+ * \param[in] sub    指向已初始化的子样本集
+ * \param[in] screen 指向已初始化的两阶段寻优设置
+ */
+static void free_screen(struct sp_wrap *sub, struct stump_screen *screen);
+
 /*******************************************************************************
  *				    函数实现
  ******************************************************************************/
@@ -88,20 +132,68 @@ flt_t haar_stump_cf_h(const void *stump, imgsz_t h, imgsz_t w, imgsz_t wid,
 				     scale));
 }
 
+flt_t haar_stump_std_h(const void *stump, imgsz_t wid, const sample_t x[][wid],
+		       flt_t std_dev, flt_t scale)
+{
+	const struct haar_stump *cstump = stump;
+	return cstump_h(&cstump->base,
+			get_norm_value(&cstump->feature, wid, x, std_dev,
+				       scale));
+}
+
+flt_t haar_stump_cf_std_h(const void *stump, imgsz_t wid,
+			  const sample_t x[][wid], flt_t std_dev, flt_t scale)
+{
+	const struct haar_stump_cf *cstump = stump;
+	return cstump_cf_h(&cstump->base,
+			   get_norm_value(&cstump->feature, wid, x, std_dev,
+					  scale));
+}
+
+flt_t haar_stump_std_dev(imgsz_t h, imgsz_t w, imgsz_t wid,
+			 const sample_t x[h][wid], const sample_t x2[h][wid])
+{
+	return get_std_dev(h, w, wid, x, x2);
+}
+
+void haar_stump_compile(struct wl_haar_compiled *dst, const void *stump,
+			imgsz_t wid, flt_t scale)
+{
+	const struct haar_stump *cstump = stump;
+	compile_feature(dst, &cstump->feature, wid, scale);
+	dst->value = cstump->base.value * scale * scale;
+	dst->output[0] = cstump->base.output[0];
+	dst->output[1] = cstump->base.output[1];
+}
+
+void haar_stump_cf_compile(struct wl_haar_compiled *dst, const void *stump,
+			   imgsz_t wid, flt_t scale)
+{
+	const struct haar_stump_cf *cstump = stump;
+	compile_feature(dst, &cstump->feature, wid, scale);
+	dst->value = cstump->base.value * scale * scale;
+	dst->output[0] = cstump->base.output[0];
+	dst->output[1] = cstump->base.output[1];
+}
+
 bool haar_stump_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
 		      const sample_t * const X[], const sample_t * const X2[],
-		      const label_t Y[], const flt_t D[])
+		      const label_t Y[], const flt_t D[], const void *param,
+		      struct train_ctx *ctx)
 {
-	return TRAIN(stump, m, h, w, X, X2, Y, D, struct haar_stump *, cstump_opt);
+	return TRAIN(stump, m, h, w, X, X2, Y, D, param, ctx,
+		     struct haar_stump *, cstump_opt, cstump_screen_opt);
 }
 
 bool haar_stump_cf_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
 			 const sample_t * const X[],
 			 const sample_t * const X2[], const label_t Y[],
-			 const flt_t D[])
+			 const flt_t D[], const void *param,
+			 struct train_ctx *ctx)
 {
-	return TRAIN(stump, m, h, w, X, X2, Y, D, struct haar_stump_cf *,
-		     cstump_cf_opt);
+	return TRAIN(stump, m, h, w, X, X2, Y, D, param, ctx,
+		     struct haar_stump_cf *, cstump_cf_opt,
+		     cstump_cf_screen_opt);
 }
 
 /*******************************************************************************
@@ -109,7 +201,7 @@ bool haar_stump_cf_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
  ******************************************************************************/
 bool init_train(struct sp_wrap *sp, struct stump_opt_handles *handles,
 		const sample_t * const *X, const sample_t * const *X2, num_t m,
-		imgsz_t h, imgsz_t w)
+		imgsz_t h, imgsz_t w, struct train_ctx *ctx)
 {
 	if ((sp->vector = malloc(sizeof(sample_t) * m)) == NULL)
 		return false;
@@ -117,12 +209,14 @@ bool init_train(struct sp_wrap *sp, struct stump_opt_handles *handles,
 	sp->X2 = X2;
 	sp->h = h;
 	sp->w = w;
+	sp->ctx = ctx;
 
 	handles->init_feature = init_feature;
 	handles->next_feature = next_feature;
 	handles->update_opt = update_opt;
 	handles->get_vals.raw = get_vals_raw;
 	handles->get_vals.sort = NULL;
+	handles->ctx = ctx;
 
 	return true;
 }
@@ -131,3 +225,74 @@ void free_train(struct sp_wrap *sp)
 {
 	free(sp->vector);
 }
+
+bool init_screen(struct sp_wrap *sub, struct stump_screen *screen,
+		 const struct wl_opt_param *param, const struct sp_wrap *sp,
+		 num_t m, const label_t Y[], const flt_t D[])
+{
+	num_t sub_m = param->sub_m;
+	const sample_t **X = malloc(sizeof(sample_t *) * sub_m);
+	const sample_t **X2 = malloc(sizeof(sample_t *) * sub_m);
+	label_t *sub_Y = malloc(sizeof(label_t) * sub_m);
+	flt_t *sub_D = malloc(sizeof(flt_t) * sub_m);
+	sub->vector = malloc(sizeof(sample_t) * sub_m);
+	if (X == NULL || X2 == NULL || sub_Y == NULL || sub_D == NULL
+	    || sub->vector == NULL)
+		goto err;
+
+	// 系统重采样：以 [0, step) 内的随机数为起点、step 为间隔，在概率分布的
+	// 累积和上等距取样，样本被选中的次数正比于其概率
+	flt_t total = 0;
+	for (num_t i = 0; i < m; ++i)
+		total += D[i];
+	flt_t step = total / sub_m;
+	flt_t u = step * train_rand(sp->ctx) / ((flt_t) RAND_MAX + 1);
+	flt_t cum = 0;
+	num_t j = 0;
+	for (num_t i = 0; i < m && j < sub_m; ++i) {
+		cum += D[i];
+		for (; j < sub_m && u < cum; ++j, u += step) {
+			X[j] = sp->X[i];
+			X2[j] = sp->X2[i];
+			sub_Y[j] = Y[i];
+		}
+	}
+	// 舍入误差导致未取满时，以最后一个样本补足
+	for (; j < sub_m; ++j) {
+		X[j] = sp->X[m - 1];
+		X2[j] = sp->X2[m - 1];
+		sub_Y[j] = Y[m - 1];
+	}
+	for (j = 0; j < sub_m; ++j)
+		sub_D[j] = 1.0 / sub_m;
+
+	sub->X = X;
+	sub->X2 = X2;
+	sub->h = sp->h;
+	sub->w = sp->w;
+	sub->ctx = sp->ctx;
+	screen->top_k = param->top_k;
+	screen->sub_m = sub_m;
+	screen->sub_samples = sub;
+	screen->sub_label = sub_Y;
+	screen->sub_D = sub_D;
+	screen->check = param->check;
+	return true;
+
+err:
+	free(X);
+	free(X2);
+	free(sub_Y);
+	free(sub_D);
+	free(sub->vector);
+	return false;
+}
+
+void free_screen(struct sp_wrap *sub, struct stump_screen *screen)
+{
+	free((void *)sub->X);
+	free((void *)sub->X2);
+	free((void *)screen->sub_label);
+	free((void *)screen->sub_D);
+	free(sub->vector);
+}
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "stump_base.h"
+#include "../weaklearner.h"
 
 /**
  * \file haar_stump.h
@@ -75,13 +76,49 @@ flt_t haar_stump_cf_h(const void *stump, imgsz_t h, imgsz_t w, imgsz_t wid,
 		      const sample_t x[h][wid], const sample_t x2[h][wid],
 		      flt_t scale);
 
+/**
+ * \brief haar_stump 获取分类结果（窗口标准差由调用者给出），分类结果为 -1 或 +1
+ * \details \copydetails wl_h_haar_std_fn
+ */
+flt_t haar_stump_std_h(const void *stump, imgsz_t wid, const sample_t x[][wid],
+		       flt_t std_dev, flt_t scale);
+
+/**
+ * \brief haar_stump_cf 获取分类结果（窗口标准差由调用者给出），分类结果为置信度
+ * \details \copydetails wl_h_haar_std_fn
+ */
+flt_t haar_stump_cf_std_h(const void *stump, imgsz_t wid,
+			  const sample_t x[][wid], flt_t std_dev, flt_t scale);
+
+/**
+ * \brief 计算窗口的标准差，用于 haar_stump_std_h()、haar_stump_cf_std_h()
+ * \details \copydetails wl_haar_std_dev()
+ */
+flt_t haar_stump_std_dev(imgsz_t h, imgsz_t w, imgsz_t wid,
+			 const sample_t x[h][wid], const sample_t x2[h][wid]);
+
+/**
+ * \brief haar_stump 在给定尺度、给定图像宽度下编译，输出值为 -1 或 +1
+ * \details \copydetails wl_compile_haar_fn
+ */
+void haar_stump_compile(struct wl_haar_compiled *dst, const void *stump,
+			imgsz_t wid, flt_t scale);
+
+/**
+ * \brief haar_stump_cf 在给定尺度、给定图像宽度下编译，输出值为置信度
+ * \details \copydetails wl_compile_haar_fn
+ */
+void haar_stump_cf_compile(struct wl_haar_compiled *dst, const void *stump,
+			   imgsz_t wid, flt_t scale);
+
 /**
  * \brief haar_stump 类型的训练
  * \details \copydetails wl_train_haar_fn
  */
 bool haar_stump_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
 		      const sample_t * const X[], const sample_t * const X2[],
-		      const label_t Y[], const flt_t D[]);
+		      const label_t Y[], const flt_t D[], const void *param,
+		      struct train_ctx *ctx);
 
 /**
  * \brief haar_stump_cf 类型的训练
@@ -89,6 +126,7 @@ bool haar_stump_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
  */
 bool haar_stump_cf_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
 			 const sample_t * const X[],const sample_t * const X2[],
-			 const label_t Y[], const flt_t D[]);
+			 const label_t Y[], const flt_t D[], const void *param,
+			 struct train_ctx *ctx);
 
 #endif
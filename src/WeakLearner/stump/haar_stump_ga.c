@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include "../weaklearner.h"
 #include "stump_ga_base.h"
 #include "haar_stump_pvt.h"
 #include "haar_stump_ga.h"
@@ -13,8 +14,8 @@
 /*******************************************************************************
  * 				   宏函数定义
  ******************************************************************************/
-/// 产生 [a, b] 范围内的随机整数（a、b 均为整数且 a < b）
-#define RAND_RANGE(a, b) ((a) + rand() % ((b) - (a) + 1))
+/// 以训练上下文 ctx 产生 [a, b] 范围内的随机整数（a、b 均为整数且 a < b）
+#define RAND_RANGE(ctx, a, b) ((a) + train_rand(ctx) % ((b) - (a) + 1))
 
 /**
  * \brief 获取 Haar 特征矩形宽度的上界
@@ -62,7 +63,7 @@
 #define CROSS(ind, p1, p2, member, ub_macro, args)				\
 	do {									\
 		imgsz_t ub = ub_macro(args, ind);				\
-		flt_t r = (flt_t) rand() / RAND_MAX;				\
+		flt_t r = (flt_t) train_rand((args)->ctx) / RAND_MAX;		\
 		(ind)->member = (1-r) * (p1)->member + r * (p2)->member + 0.5;	\
 		if ((ind)->member > ub)						\
 			(ind)->member = ub;					\
@@ -80,7 +81,8 @@
 #define MUTATE(ind, member, lb, ub_macro, args, step)				\
 	do {									\
 		imgsz_t ub = ub_macro(args, ind);				\
-		flt_t r = ((flt_t) rand() / RAND_MAX - 0.5) * 2 * step;		\
+		flt_t r = ((flt_t) train_rand((args)->ctx) / RAND_MAX - 0.5)	\
+		    * 2 * step;							\
 		if ((ind)->member + r > ub)					\
 			(ind)->member = ub;					\
 		else if ((ind)->member < lb - r)				\
@@ -99,10 +101,16 @@ static void ga_crossover(void *child, const void *parent1,
 			 const void *parent2, const void *samples);
 /// 进化算法回调函数：对单个个体进行变异操作
 static void ga_mutate(void *individual, const void *samples);
+/// 进化算法回调函数：以样本为主序批量计算种群上的取值
+static void get_vals_batch(num_t m, num_t n, size_t ft_size,
+			   sample_t vals[n][m], const void *features,
+			   const void *samples);
 /// 进化算法回调函数：对样本集包装结构体、回调函数集进行初始化
 static bool init_setting(struct sp_wrap *sp, struct stump_ga_handles *hl,
 			 num_t m, const sample_t * const *X,
-			 const sample_t * const *X2, imgsz_t h, imgsz_t w);
+			 const sample_t * const *X2, imgsz_t h, imgsz_t w,
+			 const struct wl_ga_param *param,
+			 struct train_ctx *ctx);
 /// 释放内存空间
 static inline void free_setting(struct sp_wrap *sp);
 
@@ -111,11 +119,12 @@ static inline void free_setting(struct sp_wrap *sp);
  ******************************************************************************/
 bool haar_stump_ga_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
 			 const sample_t * const X[], const sample_t * const X2[],
-			 const label_t Y[], const flt_t D[])
+			 const label_t Y[], const flt_t D[], const void *param,
+			 struct train_ctx *ctx)
 {
 	struct sp_wrap sp;
 	struct stump_ga_handles hl;
-	if (!init_setting(&sp, &hl, m, X, X2, h, w))
+	if (!init_setting(&sp, &hl, m, X, X2, h, w, param, ctx))
 		return false;
 
 	struct haar_stump *ptr = stump;
@@ -132,11 +141,12 @@ bool haar_stump_ga_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
 bool haar_stump_ga_cf_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
 			    const sample_t * const X[],
 			    const sample_t * const X2[], const label_t Y[],
-			    const flt_t D[])
+			    const flt_t D[], const void *param,
+			    struct train_ctx *ctx)
 {
 	struct sp_wrap sp;
 	struct stump_ga_handles hl;
-	if (!init_setting(&sp, &hl, m, X, X2, h, w))
+	if (!init_setting(&sp, &hl, m, X, X2, h, w, param, ctx))
 		return false;
 
 	struct haar_stump_cf *ptr = stump;
@@ -158,11 +168,11 @@ void ga_init(void *individual, const void *samples)
 {
 	struct haar_feature *ind = individual;
 	const struct sp_wrap *sp = samples;
-	ind->type = RAND_RANGE(FEAT_START + 1, FEAT_END - 1);
-	ind->width = RAND_RANGE(1, UB_WIDTH(sp, ind));
-	ind->height = RAND_RANGE(1, UB_HEIGHT(sp, ind));
-	ind->start_x = RAND_RANGE(0, UB_STARTX(sp, ind));
-	ind->start_y = RAND_RANGE(0, UB_STARTY(sp, ind));
+	ind->type = RAND_RANGE(sp->ctx, FEAT_START + 1, FEAT_END - 1);
+	ind->width = RAND_RANGE(sp->ctx, 1, UB_WIDTH(sp, ind));
+	ind->height = RAND_RANGE(sp->ctx, 1, UB_HEIGHT(sp, ind));
+	ind->start_x = RAND_RANGE(sp->ctx, 0, UB_STARTX(sp, ind));
+	ind->start_y = RAND_RANGE(sp->ctx, 0, UB_STARTY(sp, ind));
 }
 
 void ga_crossover(void *child, const void *parent1, const void *parent2,
@@ -173,7 +183,7 @@ void ga_crossover(void *child, const void *parent1, const void *parent2,
 	const struct haar_feature *prt2 = parent2;
 	const struct sp_wrap *sp = samples;
 
-	cld->type = ((rand() % 2) == 0) ? prt1->type : prt2->type;
+	cld->type = ((train_rand(sp->ctx) % 2) == 0) ? prt1->type : prt2->type;
 	CROSS(cld, prt1, prt2, width, UB_WIDTH, sp);
 	CROSS(cld, prt1, prt2, height, UB_HEIGHT, sp);
 	CROSS(cld, prt1, prt2, start_x, UB_STARTX, sp);
@@ -186,34 +196,71 @@ void ga_mutate(void *individual, const void *samples)
 	const struct sp_wrap *sp = samples;
 	const float step = sp->h / 4.0;
 
-	ind->type = RAND_RANGE(FEAT_START + 1, FEAT_END - 1);
+	ind->type = RAND_RANGE(sp->ctx, FEAT_START + 1, FEAT_END - 1);
 	MUTATE(ind, width, 1, UB_WIDTH, sp, step);
 	MUTATE(ind, height, 1, UB_HEIGHT, sp, step);
 	MUTATE(ind, start_x, 0, UB_STARTX, sp, step);
 	MUTATE(ind, start_y, 0, UB_STARTY, sp, step);
 }
 
+void get_vals_batch(num_t m, num_t n, size_t ft_size, sample_t vals[n][m],
+		    const void *features, const void *samples)
+{
+	const struct sp_wrap *sp = samples;
+	const struct haar_feature *ft = features;
+	flt_t std_dev;
+
+	// 外层遍历样本：每个样本的积分图只读取一次，标准差也只计算一次
+	for (num_t i = 0; i < m; ++i) {
+		train_stream(sp->ctx, i, sp->X[i]);
+		std_dev = get_std_dev(sp->h, sp->w, sp->w, (void *)sp->X[i],
+				      (void *)sp->X2[i]);
+		if (std_dev == 0) {
+			for (num_t j = 0; j < n; ++j)
+				vals[j][i] = 0;
+			continue;
+		}
+		for (num_t j = 0; j < n; ++j)
+			vals[j][i] = get_raw_value(ft + j, sp->w,
+						   (void *)sp->X[i], 1) /
+			    std_dev;
+	}
+}
+
 bool init_setting(struct sp_wrap *sp, struct stump_ga_handles *hl, num_t m,
 		  const sample_t * const *X, const sample_t * const *X2,
-		  imgsz_t h, imgsz_t w)
+		  imgsz_t h, imgsz_t w, const struct wl_ga_param *param,
+		  struct train_ctx *ctx)
 {
 	sp->X = X;
 	sp->X2 = X2;
 	sp->h = h;
 	sp->w = w;
+	sp->ctx = ctx;
 	sp->vector = malloc(sizeof(sample_t) * m);
 	if (sp->vector == NULL)
 		return false;
 
-	hl->gen = GEN;
-	hl->m = POP_SIZE;
-	hl->p_c = P_C;
-	hl->p_m = P_M;
+	struct wl_ga_param def_param;
+	if (param == NULL) {
+		wl_ga_param_default(&def_param);
+		param = &def_param;
+	}
+	hl->gen = param->gen;
+	hl->m = param->pop_size;
+	hl->p_c = param->p_c;
+	hl->p_m = param->p_m;
+	hl->stall_gen = param->stall_gen;
+	hl->time_limit = param->time_limit;
+	hl->archive = param->archive;
+	hl->seed_ratio = param->seed_ratio;
 	hl->init = ga_init;
 	hl->crossover = ga_crossover;
 	hl->mutate = ga_mutate;
 	hl->get_vals = get_vals_raw;
+	hl->get_batch = get_vals_batch;
 	hl->update_opt = update_opt;
+	hl->ctx = ctx;
 	return true;
 }
 
@@ -19,7 +19,8 @@
  */
 bool haar_stump_ga_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
 			 const sample_t * const X[], const sample_t * const X2[],
-			 const label_t Y[], const flt_t D[]);
+			 const label_t Y[], const flt_t D[], const void *param,
+			 struct train_ctx *ctx);
 
 /**
  * \brief 训练 haar_stump_cf 决策树桩弱学习器，带置信度。
@@ -29,6 +30,7 @@ bool haar_stump_ga_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
 bool haar_stump_ga_cf_train(void *stump, num_t m, imgsz_t h, imgsz_t w,
 			    const sample_t * const X[],
 			    const sample_t * const X2[], const label_t Y[],
-			    const flt_t D[]);
+			    const flt_t D[], const void *param,
+			    struct train_ctx *ctx);
 
 #endif
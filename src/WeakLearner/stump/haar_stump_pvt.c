@@ -8,6 +8,45 @@
  * \version 1.0
  * \date 2024-07-14
  */
+/*******************************************************************************
+ * 				    静态常量
+ ******************************************************************************/
+/// 积分图取值点：行索引 i[]、列索引 j[] 的下标及权重（同 get_raw_value()）
+struct haar_tap {
+	char i;			///< 行索引 i[] 的下标
+	char j;			///< 列索引 j[] 的下标
+	char weight;		///< 权重
+};
+
+/// 各类型哈尔特征的取值点数量
+static const char tap_ct[] = {
+	[LEFT_RIGHT] = 6,
+	[UP_DOWN] = 6,
+	[TRIPLE] = 8,
+	[QUAD] = 9,
+};
+
+/// 各类型哈尔特征的取值点
+static const struct haar_tap taps[][WL_HAAR_TAPS] = {
+	[LEFT_RIGHT] = {
+			{1, 2, 1}, {0, 2, -1}, {1, 1, -2},
+			{0, 1, 2}, {1, 0, 1}, {0, 0, -1},
+			},
+	[UP_DOWN] = {
+		     {1, 1, 2}, {0, 1, -1}, {1, 0, -2},
+		     {0, 0, 1}, {2, 1, -1}, {2, 0, 1},
+		     },
+	[TRIPLE] = {
+		    {1, 2, 2}, {0, 2, -2}, {1, 1, -2}, {0, 1, 2},
+		    {1, 0, 1}, {0, 0, -1}, {1, 3, -1}, {0, 3, 1},
+		    },
+	[QUAD] = {
+		  {1, 2, 2}, {0, 2, -1}, {1, 1, -4},
+		  {0, 1, 2}, {1, 0, 2}, {0, 0, -1},
+		  {2, 2, -1}, {2, 0, -1}, {2, 1, 2},
+		  },
+};
+
 /*******************************************************************************
  * 				    函数定义
  ******************************************************************************/
@@ -53,10 +92,12 @@ const sample_t *get_vals_raw(num_t m, const void *samples, const void *feature)
 {
 	const struct sp_wrap *sp = samples;
 
-	for (num_t i = 0; i < m; ++i)
+	for (num_t i = 0; i < m; ++i) {
+		train_stream(sp->ctx, i, sp->X[i]);
 		sp->vector[i] = get_value(feature, sp->h, sp->w, sp->w,
 					  (void *)sp->X[i], (void *)sp->X2[i],
 					  1);
+	}
 
 	return sp->vector;
 }
@@ -64,6 +105,23 @@ const sample_t *get_vals_raw(num_t m, const void *samples, const void *feature)
 sample_t get_value(const struct haar_feature *feat, imgsz_t h, imgsz_t w,
 		   imgsz_t wid, const sample_t x[h][wid],
 		   const sample_t x2[h][wid], flt_t scale)
+{
+	flt_t std_dev = get_std_dev(h, w, wid, x, x2);	// 标准差
+	return get_norm_value(feat, wid, x, std_dev, scale);
+}
+
+sample_t get_norm_value(const struct haar_feature *feat, imgsz_t wid,
+			const sample_t x[][wid], flt_t std_dev, flt_t scale)
+{
+	// 方差为 0，从现实意义的角度来说，哈尔特征为 0（标准差用于消除光照差异）
+	if (std_dev == 0)
+		return 0;
+
+	return get_raw_value(feat, wid, x, scale) / std_dev / scale / scale;
+}
+
+flt_t get_std_dev(imgsz_t h, imgsz_t w, imgsz_t wid, const sample_t x[h][wid],
+		  const sample_t x2[h][wid])
 {
 	h -= 1;			// 第一行弃置不用
 	w -= 1;			// 第一列弃置不用
@@ -72,39 +130,57 @@ sample_t get_value(const struct haar_feature *feat, imgsz_t h, imgsz_t w,
 	std_dev *= -std_dev;	// 计算均值的平方
 	std_dev +=
 	    (flt_t) (x2[h][w] - x2[h][0] - x2[0][w] + x2[0][0]) / (h * w);
-	// 方差为 0，从现实意义的角度来说，哈尔特征为 0（标准差用于消除光照差异）
 	if (std_dev == 0)
 		return 0;
-	std_dev = sqrt(std_dev);	// 计算标准差
+	return sqrt(std_dev);	// 计算标准差
+}
 
+sample_t get_raw_value(const struct haar_feature *feat, imgsz_t wid,
+		       const sample_t x[][wid], flt_t scale)
+{
 	flt_t start_x = feat->start_x * scale;	// 左上角横坐标
 	flt_t start_y = feat->start_y * scale;	// 左上角纵坐标
-	w = feat->width * scale;	// 单个矩形的宽度
-	h = feat->height * scale;	// 单个矩形的高度
+	imgsz_t w = feat->width * scale;	// 单个矩形的宽度
+	imgsz_t h = feat->height * scale;	// 单个矩形的高度
 	imgsz_t i[3] = { start_y, start_y + h, start_y + 2 * h };
 	imgsz_t j[4] =
 	    { start_x, start_x + w, start_x + 2 * w, start_x + 3 * w };
 	switch (feat->type) {
 	case LEFT_RIGHT:
-		return (x[i[1]][j[2]] - x[i[0]][j[2]] - 2 * x[i[1]][j[1]]
-			+ 2 * x[i[0]][j[1]] + x[i[1]][j[0]] - x[i[0]][j[0]]) /
-		    std_dev / scale / scale;
+		return x[i[1]][j[2]] - x[i[0]][j[2]] - 2 * x[i[1]][j[1]]
+		    + 2 * x[i[0]][j[1]] + x[i[1]][j[0]] - x[i[0]][j[0]];
 	case UP_DOWN:
-		return (2 * x[i[1]][j[1]] - x[i[0]][j[1]] - 2 * x[i[1]][j[0]]
-			+ x[i[0]][j[0]] - x[i[2]][j[1]] + x[i[2]][j[0]]) /
-		    std_dev / scale / scale;
+		return 2 * x[i[1]][j[1]] - x[i[0]][j[1]] - 2 * x[i[1]][j[0]]
+		    + x[i[0]][j[0]] - x[i[2]][j[1]] + x[i[2]][j[0]];
 	case TRIPLE:
-		return (2 * x[i[1]][j[2]] - 2 * x[i[0]][j[2]] -
-			2 * x[i[1]][j[1]]
-			+ 2 * x[i[0]][j[1]] + x[i[1]][j[0]] - x[i[0]][j[0]]
-			- x[i[1]][j[3]] +
-			x[i[0]][j[3]]) / std_dev / scale / scale;
+		return 2 * x[i[1]][j[2]] - 2 * x[i[0]][j[2]] -
+		    2 * x[i[1]][j[1]]
+		    + 2 * x[i[0]][j[1]] + x[i[1]][j[0]] - x[i[0]][j[0]]
+		    - x[i[1]][j[3]] + x[i[0]][j[3]];
 	case QUAD:
-		return (2 * x[i[1]][j[2]] - x[i[0]][j[2]] - 4 * x[i[1]][j[1]]
-			+ 2 * x[i[0]][j[1]] + 2 * x[i[1]][j[0]] - x[i[0]][j[0]]
-			- x[i[2]][j[2]] - x[i[2]][j[0]] + 2 * x[i[2]][j[1]]) /
-		    std_dev / scale / scale;
+		return 2 * x[i[1]][j[2]] - x[i[0]][j[2]] - 4 * x[i[1]][j[1]]
+		    + 2 * x[i[0]][j[1]] + 2 * x[i[1]][j[0]] - x[i[0]][j[0]]
+		    - x[i[2]][j[2]] - x[i[2]][j[0]] + 2 * x[i[2]][j[1]];
 	default:
 		return NAN;
 	}
 }
+
+void compile_feature(struct wl_haar_compiled *dst,
+		     const struct haar_feature *feat, imgsz_t wid, flt_t scale)
+{
+	flt_t start_x = feat->start_x * scale;	// 左上角横坐标
+	flt_t start_y = feat->start_y * scale;	// 左上角纵坐标
+	imgsz_t w = feat->width * scale;	// 单个矩形的宽度
+	imgsz_t h = feat->height * scale;	// 单个矩形的高度
+	imgsz_t i[3] = { start_y, start_y + h, start_y + 2 * h };
+	imgsz_t j[4] =
+	    { start_x, start_x + w, start_x + 2 * w, start_x + 3 * w };
+
+	dst->n = tap_ct[feat->type];
+	for (num_t k = 0; k < dst->n; ++k) {
+		const struct haar_tap *tap = &taps[feat->type][k];
+		dst->offset[k] = (ptrdiff_t) i[(int)tap->i] * wid + j[(int)tap->j];
+		dst->weight[k] = tap->weight;
+	}
+}
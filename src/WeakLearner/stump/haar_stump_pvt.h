@@ -38,6 +38,7 @@ struct sp_wrap {
 	imgsz_t h;			///< 训练图像高度
 	imgsz_t w;			///< 训练图像宽度
 	sample_t *vector;		///< 保存样本集在某一特征上的取值
+	struct train_ctx *ctx;		///< 训练上下文，可为 NULL
 };
 
 /*******************************************************************************
@@ -52,6 +53,29 @@ void update_opt(void *opt, const void *feature);
 /// 获取特征数组
 const sample_t *get_vals_raw(num_t m, const void *samples, const void *feature);
 
+/**
+ * \brief 计算截取图像的标准差（用于消除光照差异）
+ * \param[in] h     截取的图像高度
+ * \param[in] w     截取的图像宽度
+ * \param[in] wid   原图像宽度
+ * \param[in] x     积分图（二维数组，h * w 大小）
+ * \param[in] x2    灰度值平方的积分图（二维数组，h * w 大小）
+ * \return 返回截取图像的标准差；方差为 0 时返回 0
+ */
+flt_t get_std_dev(imgsz_t h, imgsz_t w, imgsz_t wid, const sample_t x[h][wid],
+		  const sample_t x2[h][wid]);
+
+/**
+ * \brief 计算样本在指定特征上的矩形和（未经标准差、缩放比例归一化）
+ * \param[in] feat  指定特征
+ * \param[in] wid   原图像宽度
+ * \param[in] x     积分图
+ * \param[in] scale 缩放比例，即检测图像尺寸：训练图像尺寸
+ * \return 返回样本在特征 feat 上的矩形和
+ */
+sample_t get_raw_value(const struct haar_feature *feat, imgsz_t wid,
+		       const sample_t x[][wid], flt_t scale);
+
  /**
  * \brief 计算样本在指定特征上的取值
  * \param[in] feat  指定特征，函数将返回样本在该特征上的取值
@@ -67,4 +91,26 @@ sample_t get_value(const struct haar_feature *feat, imgsz_t h, imgsz_t w,
 		   imgsz_t wid, const sample_t x[h][wid],
 		   const sample_t x2[h][wid], flt_t scale);
 
+/**
+ * \brief 计算样本在指定特征上的取值（窗口标准差已知）
+ * \param[in] feat    指定特征
+ * \param[in] wid     原图像宽度
+ * \param[in] x       积分图
+ * \param[in] std_dev 窗口的标准差，见 get_std_dev()
+ * \param[in] scale   缩放比例，即检测图像尺寸：训练图像尺寸
+ * \return 返回样本在特征 feat 上的取值，与 get_value() 相同
+ */
+sample_t get_norm_value(const struct haar_feature *feat, imgsz_t wid,
+			const sample_t x[][wid], flt_t std_dev, flt_t scale);
+
+/**
+ * \brief 将特征展开为积分图上的偏移量及权重（不设置划分值及输出值），取值点的
+ * 	位置与 get_raw_value() 完全一致
+ * \param[out] dst  用于保存编译结果
+ * \param[in] feat  指定特征
+ * \param[in] wid   原图像宽度
+ * \param[in] scale 缩放比例，即检测图像尺寸：训练图像尺寸
+ */
+void compile_feature(struct wl_haar_compiled *dst,
+		     const struct haar_feature *feat, imgsz_t wid, flt_t scale);
 #endif
@@ -108,6 +108,52 @@ do {										\
 	} while (handles->next_feature (feature, samples));			\
 } while(0)
 
+/**
+ * \brief 多标签决策树桩训练，各标签共用特征的排序，每个特征只扫描一次
+ * \param[out] stump   决策树桩基类数组（相邻元素相距 stride 字节）
+ * \param[out] opt     最优划分属性数组（相邻元素相距 stride 字节）
+ * \param[in] ft_size  单个属性变量的长度（字节）
+ * \param[in] stride   相邻决策树桩的间隔（字节）
+ * \param[in] dim      标签数量
+ * \param[in] m        样本数量
+ * \param[in] samples  样本集
+ * \param[in] label    标签集（dim × m 数组）
+ * \param[in] D        概率分布（dim × m 数组）
+ * \param[in] handles  操作当前决策树桩的回调函数集合
+ * \param[in] update   更新决策树桩的回调函数，如 cstump_update
+ * \return 成功则返回真，否则返回假
+ */
+#define MULTI_TRAIN(stump, opt, ft_size, stride, dim, m, samples, label, D,	\
+		    handles, update)						\
+({										\
+	bool status = false;							\
+	struct cstump_multi *mt = cstump_multi_init(m, dim, label, D);		\
+	if (mt != NULL) {							\
+		char feature[ft_size];						\
+		struct cstump_segment seg[dim];					\
+		flt_t min_z[dim];						\
+		for (mlabel_t l = 0; l < (dim); ++l)				\
+			min_z[l] = DBL_MAX;					\
+		handles->init_feature (feature, samples);			\
+		do {								\
+			cstump_multi_get_z(seg, mt, feature, m, samples,	\
+					   handles);				\
+			for (mlabel_t l = 0; l < (dim); ++l) {			\
+				if (seg[l].z >= min_z[l])			\
+					continue;				\
+				min_z[l] = seg[l].z;				\
+				update ((void *)((char *)(stump)		\
+						+ l * (stride)), &seg[l]);	\
+				handles->update_opt ((char *)(opt)		\
+						     + l * (stride), feature);	\
+			}							\
+		} while (handles->next_feature (feature, samples));		\
+		free(mt);							\
+		status = true;							\
+	}									\
+	status;									\
+})
+
 /*******************************************************************************
  * 				    函数实现
  ******************************************************************************/
@@ -139,6 +185,25 @@ bool cstump_cf_opt(struct cstump_cf_base *stump, void *opt, size_t ft_size,
 	return true;
 }
 
+bool cstump_multi_opt(struct cstump_base *stump, void *opt, size_t ft_size,
+		      size_t stride, mlabel_t dim, num_t m,
+		      const void *samples, const label_t * label,
+		      const flt_t * D, const struct stump_opt_handles *handles)
+{
+	return MULTI_TRAIN(stump, opt, ft_size, stride, dim, m, samples, label,
+			   D, handles, cstump_update);
+}
+
+bool cstump_cf_multi_opt(struct cstump_cf_base *stump, void *opt,
+			 size_t ft_size, size_t stride, mlabel_t dim, num_t m,
+			 const void *samples, const label_t * label,
+			 const flt_t * D,
+			 const struct stump_opt_handles *handles)
+{
+	return MULTI_TRAIN(stump, opt, ft_size, stride, dim, m, samples, label,
+			   D, handles, cstump_cf_update);
+}
+
 bool dstump_opt(struct dstump_base *stump, void *opt, size_t ft_size,
 		num_t m, const void *samples, const label_t * label,
 		const flt_t * D, const struct stump_opt_handles *handles)
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "boost_cfg.h"
+#include "train_ctx.h"
 
 /**
  * \file stump_base.h
@@ -112,6 +113,7 @@ struct stump_opt_handles {
 		st_get_sorted_fn sort;	///< 返回排序后的特征数组索引
                                         /**< 可置为 NULL，此时将使用自带的排序方法 */
 	} get_vals;			///< 结构体，获取样本集在当前特征上的取值
+	struct train_ctx *ctx;		///< 训练上下文（随机划分、划分间隔），可为 NULL
 };
 
 /*******************************************************************************
@@ -141,6 +143,39 @@ bool cstump_cf_opt(struct cstump_cf_base *stump, void *opt, size_t ft_size,
 		   num_t m, const void *samples, const label_t * label,
 		   const flt_t * D, const struct stump_opt_handles *handles);
 
+/**
+ * \brief 同时为 dim 个标签获取 cstump_base 类型决策树桩的最优划分属性。
+ * 	各特征的取值只排序、扫描一次，每个样本同时更新所有标签的权重；第 l 个
+ * 	决策树桩的结果与以第 l 行标签及概率分布调用 cstump_opt()（使用排序结果）
+ * 	相同
+ * \param[out] stump  未初始化的决策树桩数组，相邻元素相距 stride 字节
+ * \param[in] opt     用于保存最优划分属性的变量地址，相邻元素相距 stride 字节
+ * \param[in] ft_size 单个属性变量的长度（字节），即特征类型的长度
+ * \param[in] stride  相邻决策树桩的间隔（字节）
+ * \param[in] dim     标签数量
+ * \param[in] m       样本数量
+ * \param[in] samples 指向样本集的指针
+ * \param[in] label   标签集（dim × m 数组，每行为一个标签的样本标签）
+ * \param[in] D       概率分布（dim × m 数组，每行为一个标签的概率分布）
+ * \param[in] handles 已初始化的回调函数集合；get_vals.sort 为 NULL 时对各
+ * 	特征的取值排序
+ * \return 训练成功则返回真，否则返回假
+ */
+bool cstump_multi_opt(struct cstump_base *stump, void *opt, size_t ft_size,
+		      size_t stride, mlabel_t dim, num_t m,
+		      const void *samples, const label_t * label,
+		      const flt_t * D, const struct stump_opt_handles *handles);
+
+/**
+ * \brief 同时为 dim 个标签获取 cstump_cf_base 类型决策树桩的最优划分属性
+ * \details \copydetails cstump_multi_opt()
+ */
+bool cstump_cf_multi_opt(struct cstump_cf_base *stump, void *opt,
+			 size_t ft_size, size_t stride, mlabel_t dim, num_t m,
+			 const void *samples, const label_t * label,
+			 const flt_t * D,
+			 const struct stump_opt_handles *handles);
+
 /**
  * \brief 获取 dstump_base 类型决策树桩的最优划分属性
  * \details \copydetails cstump_opt()
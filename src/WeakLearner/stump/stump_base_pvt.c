@@ -31,8 +31,10 @@
  * \param[out] p   用于保存分位置的索引（X[*p..] > *seg）
  * \param[in]  X   要进行划分的指针数组
  * \param[in]  m   数组长度
+ * \param[in, out] ctx 训练上下文，可为 NULL
  */
-static void partition(flt_t * seg, num_t * p, const sample_t * X[], num_t m);
+static void partition(flt_t * seg, num_t * p, const sample_t * X[], num_t m,
+		      struct train_ctx *ctx);
 
 /**
  * \brief 获取单个属性的最优划分值
@@ -46,12 +48,14 @@ static void partition(flt_t * seg, num_t * p, const sample_t * X[], num_t m);
  * \param[in] m      样本数量
  * \param[in] left   在 X 最左侧进行划分的划分值
  * \param[in] right  在 X 最右侧进行划分的划分值
+ * \param[in, out] ctx 训练上下文，可为 NULL
  */
 static void quick_get_segment(struct cstump_segment *best, const sample_t * X0,
 			      const sample_t * X[], const label_t Y[],
 			      const flt_t D[], num_t m,
 			      const struct cstump_segment *left,
-			      const struct cstump_segment *right);
+			      const struct cstump_segment *right,
+			      struct train_ctx *ctx);
 
 /*******************************************************************************
  * 				    函数实现
@@ -59,9 +63,17 @@ static void quick_get_segment(struct cstump_segment *best, const sample_t * X0,
 void cstump_raw_get_z(struct cstump_segment *seg, const void *feature, num_t m,
 		      const void *samples, const label_t * label,
 		      const flt_t D[], const struct stump_opt_handles *handles)
+{
+	cstump_vals_get_z(seg, handles->get_vals.raw(m, samples, feature), m,
+			  label, D, handles->ctx);
+}
+
+void cstump_vals_get_z(struct cstump_segment *seg, const sample_t values[],
+		       num_t m, const label_t * label, const flt_t D[],
+		       struct train_ctx *ctx)
 {
 	const flt_t epsilon = 1.0 / m;
-	const sample_t *values = handles->get_vals.raw(m, samples, feature);
+	const flt_t interval = train_seg_interval(ctx);
 	const sample_t *X[m];
 	for (num_t i = 0; i < m; ++i)
 		X[i] = values + i;
@@ -85,8 +97,8 @@ void cstump_raw_get_z(struct cstump_segment *seg, const void *feature, num_t m,
 		p_or_n = (bool)(label[i] > 0);
 		left.W[p_or_n][1] += D[i];
 	}
-	left.value -= VEC_SEG_INTERVAL;
-	right.value += VEC_SEG_INTERVAL;
+	left.value -= interval;
+	right.value += interval;
 	// 计算左、右侧划分产生的 Z 值
 	right.W[0][0] = left.W[0][1];
 	right.W[1][0] = left.W[1][1];
@@ -94,7 +106,7 @@ void cstump_raw_get_z(struct cstump_segment *seg, const void *feature, num_t m,
 	right.z = left.z;
 	// 当前最优划分位置为左侧（左、右侧 Z 值相同）
 	*seg = left;
-	quick_get_segment(seg, values, X, label, D, m, &left, &right);
+	quick_get_segment(seg, values, X, label, D, m, &left, &right, ctx);
 }
 
 void cstump_sort_get_z(struct cstump_segment *seg, const void *feature, num_t m,
@@ -139,12 +151,132 @@ void cstump_sort_get_z(struct cstump_segment *seg, const void *feature, num_t m,
 	}
 	// 计算分割值
 	if (best_posi == 0)
-		seg->value = values[ids[best_posi]] - VEC_SEG_INTERVAL;
+		seg->value = values[ids[best_posi]] -
+		    train_seg_interval(handles->ctx);
 	else if (best_posi < m)
 		seg->value = (flt_t) (values[ids[best_posi - 1]] +
 				      values[ids[best_posi]]) / 2.0;
 	else
-		seg->value = values[ids[best_posi]] + VEC_SEG_INTERVAL;
+		seg->value = values[ids[m - 1]] +
+		    train_seg_interval(handles->ctx);
+}
+
+struct cstump_multi *cstump_multi_init(num_t m, mlabel_t dim,
+				       const label_t * label, const flt_t D[])
+{
+	const flt_t epsilon = 1.0 / m;
+	const label_t(*Y)[m] = (const void *)label;
+	const flt_t(*P)[m] = (const void *)D;
+	struct cstump_multi *mt = malloc(sizeof(struct cstump_multi) +
+					 sizeof(flt_t) * (2 * m + 11) * dim +
+					 sizeof(sample_t *) * m +
+					 sizeof(num_t) * (m + dim));
+	if (mt == NULL)
+		return NULL;
+
+	mt->dim = dim;
+	mt->W = (flt_t *) mt->array;
+	mt->total[0] = mt->W + (size_t) 2 * m * dim;
+	mt->total[1] = mt->total[0] + dim;
+	mt->acc = mt->total[1] + dim;
+	mt->ptrs = (const sample_t **)(mt->acc + 9 * dim);
+	mt->ids = (num_t *) (mt->ptrs + m);
+	mt->posi = mt->ids + m;
+
+	flt_t(*W)[2][dim] = (void *)mt->W;
+	for (mlabel_t l = 0; l < dim; ++l)
+		mt->total[0][l] = mt->total[1][l] = epsilon;
+	// 按样本标号顺序累加，与 cstump_sort_get_z() 的舍入一致
+	for (num_t i = 0; i < m; ++i)
+		for (mlabel_t l = 0; l < dim; ++l) {
+			bool p_or_n = (bool)(Y[l][i] > 0);
+			W[i][p_or_n][l] = P[l][i];
+			W[i][!p_or_n][l] = 0;
+			mt->total[p_or_n][l] += P[l][i];
+		}
+	return mt;
+}
+
+void cstump_multi_get_z(struct cstump_segment seg[], struct cstump_multi *mt,
+			const void *feature, num_t m, const void *samples,
+			const struct stump_opt_handles *handles)
+{
+	const mlabel_t dim = mt->dim;
+	const flt_t interval = train_seg_interval(handles->ctx);
+	const flt_t(*W)[2][dim] = (const void *)mt->W;
+	// 当前划分位置左、右两侧的负例、正例权重
+	flt_t *L0 = mt->acc, *L1 = L0 + dim, *R0 = L1 + dim, *R1 = R0 + dim;
+	// 各标签的最优 Z 值及对应的权重
+	flt_t *Z = R1 + dim, *B = Z + dim;
+	flt_t(*best)[dim] = (void *)B;
+	num_t *posi = mt->posi;
+	const sample_t *values = handles->get_vals.raw(m, samples, feature);
+	const num_t *ids;
+	mlabel_t l;
+	num_t i;
+
+	if (handles->get_vals.sort != NULL) {
+		ids = handles->get_vals.sort(m, samples, feature);
+	} else {
+		for (i = 0; i < m; ++i)
+			mt->ptrs[i] = values + i;
+		qsort(mt->ptrs, m, sizeof(sample_t *), sample_ptr_cmp);
+		for (i = 0; i < m; ++i)
+			mt->ids[i] = mt->ptrs[i] - values;
+		ids = mt->ids;
+	}
+
+	// 分割位置在最左侧的情形
+	for (l = 0; l < dim; ++l) {
+		L0[l] = L1[l] = 1.0 / m;
+		R0[l] = mt->total[0][l];
+		R1[l] = mt->total[1][l];
+		Z[l] = sqrt(L0[l] * L1[l]) + sqrt(R0[l] * R1[l]);
+		best[0][l] = L0[l];
+		best[1][l] = L1[l];
+		best[2][l] = R0[l];
+		best[3][l] = R1[l];
+		posi[l] = 0;
+	}
+	for (i = 0; i < m; ++i) {
+		// 逐步移动分割位置，所有标签同时更新（另一类的权重为 0）
+		const flt_t *w0 = W[ids[i]][0], *w1 = W[ids[i]][1];
+		for (l = 0; l < dim; ++l) {
+			R0[l] -= w0[l];
+			L0[l] += w0[l];
+			R1[l] -= w1[l];
+			L1[l] += w1[l];
+		}
+		if (i < m - 1 && values[ids[i]] == values[ids[i + 1]])
+			continue;
+		for (l = 0; l < dim; ++l) {
+			flt_t z = sqrt(L0[l] * L1[l]) + sqrt(R0[l] * R1[l]);
+			if (z < Z[l]) {
+				Z[l] = z;
+				best[0][l] = L0[l];
+				best[1][l] = L1[l];
+				best[2][l] = R0[l];
+				best[3][l] = R1[l];
+				posi[l] = i + 1;
+			}
+		}
+	}
+
+	for (l = 0; l < dim; ++l) {
+		seg[l].z = Z[l];
+		seg[l].W[0][0] = best[0][l];
+		seg[l].W[1][0] = best[1][l];
+		seg[l].W[0][1] = best[2][l];
+		seg[l].W[1][1] = best[3][l];
+		// 计算分割值
+		if (posi[l] == 0)
+			seg[l].value = values[ids[0]] - interval;
+		else if (posi[l] < m)
+			seg[l].value = (flt_t) (values[ids[posi[l] - 1]] +
+						values[ids[posi[l]]]) / 2.0;
+		else
+			seg[l].value = values[ids[m - 1]] + interval;
+	}
 }
 
 void dstump_raw_get_z(struct dstump_segment *seg, const void *feature, num_t m,
@@ -260,13 +392,14 @@ void dstump_cf_update(struct dstump_cf_base *stump,
 /*******************************************************************************
  * 				  静态函数实现
  ******************************************************************************/
-void partition(flt_t * seg, num_t * p, const sample_t * X[], num_t m)
+void partition(flt_t * seg, num_t * p, const sample_t * X[], num_t m,
+	       struct train_ctx *ctx)
 {
 	num_t i, j;
 	const sample_t *temp;
 
 	// 找出不同的两个数，取中间值作为划分值
-	i = rand() % m;
+	i = train_rand(ctx) % m;
 	temp = X[0];
 	X[0] = X[i];
 	X[i] = temp;
@@ -278,7 +411,7 @@ void partition(flt_t * seg, num_t * p, const sample_t * X[], num_t m)
 		return;
 	}
 	// 计算划分值。对于整数型属性，划分值容易出现整数，故减去一个固定小数
-	*seg = (flt_t) (*X[0] + *X[i]) / 2 - VEC_SEG_INTERVAL;
+	*seg = (flt_t) (*X[0] + *X[i]) / 2 - train_seg_interval(ctx);
 
 	// 重新排列数组，使得划分值左侧的值小于划分值，右侧则大于划分值
 	i = 0;
@@ -295,7 +428,8 @@ void partition(flt_t * seg, num_t * p, const sample_t * X[], num_t m)
 void quick_get_segment(struct cstump_segment *best, const sample_t * X0,
 		       const sample_t * X[], const label_t Y[], const flt_t D[],
 		       num_t m, const struct cstump_segment *left,
-		       const struct cstump_segment *right)
+		       const struct cstump_segment *right,
+		       struct train_ctx *ctx)
 {
 	if (m <= 1)
 		return;
@@ -304,7 +438,7 @@ void quick_get_segment(struct cstump_segment *best, const sample_t * X0,
 	num_t id;		// 保存排序后元素的索引
 	bool p_or_n;		// 表示正例(1)或负例(0)
 	struct cstump_segment curr = *left;
-	partition(&curr.value, &p, X, m);	// 获取划分位置 p
+	partition(&curr.value, &p, X, m, ctx);	// 获取划分位置 p
 	if (p == 0 || p == m)
 		return;
 	// 将划分位置从最左侧移动到索引 p
@@ -324,11 +458,12 @@ void quick_get_segment(struct cstump_segment *best, const sample_t * X0,
 		{ left->W[1][0], curr.W[1][1] }
 	};
 	if (CSTUMP_Z(W[0], W[1]) < best->z)
-		quick_get_segment(best, X0, X, Y, D, p, left, &curr);
+		quick_get_segment(best, X0, X, Y, D, p, left, &curr, ctx);
 	W[0][0] = curr.W[0][0];
 	W[1][0] = curr.W[1][0];
 	W[0][1] = right->W[0][1];
 	W[1][1] = right->W[1][1];
 	if (CSTUMP_Z(W[0], W[1]) < best->z)
-		quick_get_segment(best, X0, X + p, Y, D, m - p, &curr, right);
+		quick_get_segment(best, X0, X + p, Y, D, m - p, &curr, right,
+				  ctx);
 }
@@ -34,6 +34,20 @@ struct dstump_segment {
 	char array[];		///< 柔性数组，value、W 实际存储位置
 };
 
+/// 多标签 cstump 系列划分的工作区：各标签共用特征的排序，同时扫描
+struct cstump_multi {
+	mlabel_t dim;		///< 标签数量
+	flt_t *W;		///< 按样本转置的权重（m × 2 × dim 数组）
+	/**< W[i][0][l]、W[i][1][l] 分别为第 i 个样本在标签 l 下的负例、正例
+	 * 权重，其中一项为 0，以便对所有标签做相同的累加 */
+	flt_t *total[2];	///< 各标签的负例、正例权重之和（含 1/m 修正）
+	flt_t *acc;		///< 扫描时的累加器及各标签的最优划分（9 × dim）
+	num_t *posi;		///< 各标签的最优划分位置
+	num_t *ids;		///< 排序结果（无排序缓存时使用）
+	const sample_t **ptrs;	///< 排序缓冲区（无排序缓存时使用）
+	char array[];		///< 柔性数组，以上数组的实际存储位置
+};
+
 /*******************************************************************************
  * 				函数声明（私有）
  ******************************************************************************/
@@ -51,6 +65,19 @@ void cstump_raw_get_z(struct cstump_segment *seg, const void *feature,
 		      num_t m, const void *samples, const label_t * label,
 		      const flt_t D[], const struct stump_opt_handles *handles);
 
+/**
+ * \brief 为 cstump 系列类型获取最优划分值（样本集在当前特征上的取值已给出）
+ * \param[out] seg    用于保存最优划分值
+ * \param[in]  values 样本集在当前特征上的取值（未排序）
+ * \param[in]  m      样本数量
+ * \param[in] label   样本集标签
+ * \param[in]  D      样本集的概率分布
+ * \param[in, out] ctx 训练上下文，可为 NULL
+ */
+void cstump_vals_get_z(struct cstump_segment *seg, const sample_t values[],
+		       num_t m, const label_t * label, const flt_t D[],
+		       struct train_ctx *ctx);
+
 /**
  * \brief 为 cstump 系列类型已排序特征数组计算最优划分值
  * \details \copydetails cstump_raw_get_z()
@@ -60,6 +87,33 @@ void cstump_sort_get_z(struct cstump_segment *seg, const void *feature,
 		       const flt_t D[],
 		       const struct stump_opt_handles *handles);
 
+/**
+ * \brief 创建多标签 cstump 系列划分的工作区
+ * \param[in] m     样本数量
+ * \param[in] dim   标签数量
+ * \param[in] label 标签集（dim × m 数组，第 l 行为标签 l 的样本标签）
+ * \param[in] D     概率分布（dim × m 数组，第 l 行为标签 l 的概率分布）
+ * \return 成功则返回工作区，可直接使用 free() 释放；否则返回 NULL
+ */
+struct cstump_multi *cstump_multi_init(num_t m, mlabel_t dim,
+				       const label_t * label, const flt_t D[]);
+
+/**
+ * \brief 为 cstump 系列类型同时获取所有标签在当前特征上的最优划分值。
+ * 	特征按取值排序后只扫描一次，每个样本同时更新所有标签的权重；各标签的
+ * 	结果与 cstump_sort_get_z() 相同
+ * \param[out] seg    用于保存各标签的最优划分值（长度为 mt->dim）
+ * \param[in, out] mt cstump_multi_init() 创建的工作区
+ * \param[in] feature 当前特征
+ * \param[in] m       样本数量
+ * \param[in] samples 样本集
+ * \param[in] handles 操作当前决策树桩的回调函数；get_vals.sort 为 NULL 时
+ * 	对特征取值排序
+ */
+void cstump_multi_get_z(struct cstump_segment seg[], struct cstump_multi *mt,
+			const void *feature, num_t m, const void *samples,
+			const struct stump_opt_handles *handles);
+
 /**
  * \brief 为 dstump 系列类型获取最优划分值
  *      （seg 各字段需初始化，seg->len 初始化为样本数量）
@@ -1,8 +1,10 @@
+#include <time.h>
 #include <stdlib.h>
 #include <string.h>
 #include <float.h>
 #include "stump_ga_base.h"
 #include "stump_base_pvt.h"
+#include "atomic_pvt.h"
 /**
  * \file stump_ga_base.c
  * \brief stump_base 训练方法重载，使用进化算法寻优（函数实现）
@@ -11,10 +13,43 @@
  * \date 2024-07-13
  */
 
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 适应值缓存的表项
+struct fit_item {
+	bool used;			///< 表项是否已被占用
+	struct cstump_segment seg;	///< 个体对应的最优划分，seg.z 即适应值
+	unsigned char key[];		///< 个体（按字节比较，个体类型不应含填充字节）
+};
+
+/// 精英个体档案（环形缓冲区）
+struct stump_ga_archive {
+	num_t cap;			///< 最多保存的个体数量
+	num_t n;			///< 已保存的个体数量
+	num_t next;			///< 下一个写入位置
+	size_t size;			///< 单个个体的长度（首次写入时确定）
+	unsigned char *items;		///< 个体数组，首次写入时分配
+};
+
+/// 适应值缓存：以个体为键的开放定址哈希表，仅在单次 ga() 调用内有效
+struct fit_cache {
+	size_t size;			///< 单个个体的长度（字节）
+	size_t stride;			///< 单个表项的长度（字节）
+	size_t mask;			///< 表项数量 - 1（表项数量为 2 的幂）
+	unsigned char *items;		///< 表项数组
+};
+
+/*******************************************************************************
+ * 				    静态变量
+ ******************************************************************************/
+/// 适应值缓存的统计信息
+static struct stump_ga_stat ga_stat;
+
 /*******************************************************************************
  * 				  静态函数声明
  ******************************************************************************/
-/// 种群初始化
+/// 种群初始化，部分个体由精英个体档案产生
 static void init_pop(num_t m, size_t size, unsigned char population[][size],
 		     const void *samples, const struct stump_ga_handles *hl);
 /// 选择，采用二元锦标赛（父代个体、子代个体一同进入筛选，筛选出的个体保存到父代中
@@ -28,19 +63,68 @@ static void crossover(num_t m, size_t size, unsigned char children[][size],
 /// 变异
 static void mutation(num_t m, size_t size, unsigned char children[][size],
 		     const void *samples, const struct stump_ga_handles *hl);
-/// 计算种群适应值
+/**
+ * \brief 计算种群适应值
+ * \param[out] vals   种群各个体的适应值
+ * \param[in] sp_m    样本数量
+ * \param[in] samples 样本集
+ * \param[in] label   样本集标签
+ * \param[in] D       样本集的概率分布
+ * \param[in] m       种群数量
+ * \param[in] size    单个个体的长度
+ * \param[in] population 种群
+ * \param[in, out] cache 适应值缓存，已评估过的个体直接读取缓存
+ * \param[out] batch  m * sp_m 大小的取值矩阵；hl->get_batch 为 NULL 时不使用
+ * \param[out] miss   m 个个体大小的缓冲区，用于存放缓存未命中的个体；
+ *      hl->get_batch 为 NULL 时不使用
+ * \param[in] hl      回调函数集
+ */
 static void fit_val(flt_t vals[], num_t sp_m, const void *samples,
 		    const label_t * label, const flt_t * D, num_t m,
 		    size_t size, const unsigned char population[][size],
+		    struct fit_cache *cache, sample_t batch[][sp_m],
+		    unsigned char miss[][size],
 		    const struct stump_ga_handles *hl);
 
+/**
+ * \brief 初始化适应值缓存
+ * \param[out] cache 未初始化的缓存
+ * \param[in] size   单个个体的长度（字节）
+ * \param[in] n      最多存放的个体数量
+ * \return 成功则返回真，失败则返回假
+ */
+static bool cache_init(struct fit_cache *cache, size_t size, size_t n);
+
+/**
+ * \brief 在适应值缓存中查找个体，若不存在则为其占用一个新表项
+ * \param[in, out] cache 已初始化的缓存
+ * \param[in] key        个体
+ * \param[out] found     个体已存在时置为真，新占用表项时置为假
+ * \return 返回个体对应的表项；新表项的 seg 成员未初始化
+ */
+static struct fit_item *cache_get(struct fit_cache *cache, const void *key,
+				  bool *found);
+
+/// 释放适应值缓存
+static inline void cache_free(struct fit_cache *cache);
+
+/**
+ * \brief 将个体保存到精英个体档案，已存在的个体不重复保存
+ *      （内存不足时放弃保存，仅影响后续热启动）
+ */
+static void archive_push(struct stump_ga_archive *archive,
+			 const void *individual, size_t size);
+
+/// 返回自 start 时刻起经过的时间（秒）
+static flt_t elapsed(const struct timespec *start);
+
 /// 获取数组最小值的索引
 static num_t argmin(flt_t vals[], num_t m);
 
-/// 进化算法框架。成功则返回真，失败返回假
-static bool ga(void *opt, size_t ft_size, num_t m, const void *samples,
-	       const label_t * label, const flt_t * D,
-	       const struct stump_ga_handles *handles);
+/// 进化算法框架，最优个体保存到 opt，其最优划分保存到 seg。成功则返回真，失败返回假
+static bool ga(void *opt, struct cstump_segment *seg, size_t ft_size,
+	       num_t m, const void *samples, const label_t * label,
+	       const flt_t * D, const struct stump_ga_handles *handles);
 
 /*******************************************************************************
  * 				    函数定义
@@ -49,14 +133,10 @@ bool cstump_ga(struct cstump_base *stump, void *opt, size_t ft_size,
 	       num_t m, const void *samples, const label_t * label,
 	       const flt_t * D, const struct stump_ga_handles *handles)
 {
-	if (!ga(opt, ft_size, m, samples, label, D, handles))
+	struct cstump_segment seg;
+	if (!ga(opt, &seg, ft_size, m, samples, label, D, handles))
 		return false;
 
-	struct cstump_segment seg;
-	struct stump_opt_handles opt_hl = {
-		.get_vals.raw = handles->get_vals,
-	};
-	cstump_raw_get_z(&seg, opt, m, samples, label, D, &opt_hl);
 	cstump_update(stump, &seg);
 	return true;
 }
@@ -65,18 +145,49 @@ bool cstump_cf_ga(struct cstump_cf_base *stump, void *opt, size_t ft_size,
 		  num_t m, const void *samples, const label_t * label,
 		  const flt_t * D, const struct stump_ga_handles *handles)
 {
-	if (!ga(opt, ft_size, m, samples, label, D, handles))
+	struct cstump_segment seg;
+	if (!ga(opt, &seg, ft_size, m, samples, label, D, handles))
 		return false;
 
-	struct cstump_segment seg;
-	struct stump_opt_handles opt_hl = {
-		.get_vals.raw = handles->get_vals,
-	};
-	cstump_raw_get_z(&seg, opt, m, samples, label, D, &opt_hl);
 	cstump_cf_update(stump, &seg);
 	return true;
 }
 
+void stump_ga_get_stat(struct stump_ga_stat *stat)
+{
+	stat->lookup = ATOMIC_LOAD(ga_stat.lookup);
+	stat->hit = ATOMIC_LOAD(ga_stat.hit);
+}
+
+void stump_ga_reset_stat(void)
+{
+	ATOMIC_STORE(ga_stat.lookup, 0);
+	ATOMIC_STORE(ga_stat.hit, 0);
+}
+
+struct stump_ga_archive *stump_ga_archive_new(num_t cap)
+{
+	if (cap == 0)
+		return NULL;
+	struct stump_ga_archive *archive = malloc(sizeof(*archive));
+	if (archive == NULL)
+		return NULL;
+	archive->cap = cap;
+	archive->n = 0;
+	archive->next = 0;
+	archive->size = 0;
+	archive->items = NULL;
+	return archive;
+}
+
+void stump_ga_archive_free(struct stump_ga_archive *archive)
+{
+	if (archive == NULL)
+		return;
+	free(archive->items);
+	free(archive);
+}
+
 /*******************************************************************************
  * 				  静态函数实现
  ******************************************************************************/
@@ -84,7 +195,21 @@ bool cstump_cf_ga(struct cstump_cf_base *stump, void *opt, size_t ft_size,
 void init_pop(num_t m, size_t size, unsigned char population[][size],
 	      const void *samples, const struct stump_ga_handles *hl)
 {
-	for (num_t i = 0; i < m; ++i)
+	num_t i = 0;
+	const struct stump_ga_archive *archive = hl->archive;
+	if (archive != NULL && archive->n > 0 && archive->size == size) {
+		num_t k = hl->seed_ratio * m;
+		if (k > m)
+			k = m;
+		// 档案中的个体直接进入种群，名额有余时用其变异个体补足
+		for (; i < k; ++i) {
+			memcpy(population[i],
+			       archive->items + i % archive->n * size, size);
+			if (i >= archive->n)
+				hl->mutate(population[i], samples);
+		}
+	}
+	for (; i < m; ++i)
 		hl->init(population[i], samples);
 }
 
@@ -112,11 +237,11 @@ void crossover(num_t m, size_t size, unsigned char children[][size],
 		ids[i] = i;
 
 	for (i = 0; i < m; ++i) {
-		if (rand() > hl->p_c * RAND_MAX) {
+		if (train_rand(hl->ctx) > hl->p_c * RAND_MAX) {
 			memcpy(children[i], population[i], size);
 			continue;
 		}
-		j = rand() % (m - i);
+		j = train_rand(hl->ctx) % (m - i);
 		hl->crossover(children[i], population[i], population[ids[j]],
 			      samples);
 		ids[j] = ids[m - i - 1];
@@ -130,7 +255,7 @@ void mutation(num_t m, size_t size, unsigned char children[][size],
 	const flt_t step = 5;
 
 	for (num_t i = 0; i < m; ++i) {
-		if (rand() > hl->p_m * RAND_MAX)
+		if (train_rand(hl->ctx) > hl->p_m * RAND_MAX)
 			continue;
 		hl->mutate(children[i], samples);
 	}
@@ -139,18 +264,120 @@ void mutation(num_t m, size_t size, unsigned char children[][size],
 // 计算种群适应值
 void fit_val(flt_t vals[], num_t sp_m, const void *samples,
 	     const label_t * label, const flt_t * D, num_t m, size_t size,
-	     const unsigned char population[][size],
+	     const unsigned char population[][size], struct fit_cache *cache,
+	     sample_t batch[][sp_m], unsigned char miss[][size],
 	     const struct stump_ga_handles *hl)
 {
-	struct stump_opt_handles opt_hl = {
-		.get_vals.raw = hl->get_vals,
-	};
-	struct cstump_segment seg;
-	for (num_t i = 0; i < m; ++i) {
-		cstump_raw_get_z(&seg, population[i], sp_m, samples, label, D,
-				 &opt_hl);
-		vals[i] = seg.z;
+	num_t i;
+	num_t n = 0;			// 缓存未命中的个体数量
+	num_t miss_id[m];		// 缓存未命中的个体索引
+	struct fit_item *items[m];	// 各个体对应的缓存表项
+	bool found;
+	for (i = 0; i < m; ++i) {
+		items[i] = cache_get(cache, population[i], &found);
+		ATOMIC_ADD(ga_stat.lookup, 1);
+		if (found)
+			ATOMIC_ADD(ga_stat.hit, 1);
+		else
+			miss_id[n++] = i;
+	}
+
+	if (n > 0 && hl->get_batch != NULL) {
+		// 以样本为主序一次性计算未命中个体的取值，再逐个体求最优划分
+		for (i = 0; i < n; ++i)
+			memcpy(miss[i], population[miss_id[i]], size);
+		hl->get_batch(sp_m, n, size, batch, miss, samples);
+		for (i = 0; i < n; ++i)
+			cstump_vals_get_z(&items[miss_id[i]]->seg, batch[i],
+					  sp_m, label, D, hl->ctx);
+	} else if (n > 0) {
+		struct stump_opt_handles opt_hl = {
+			.get_vals.raw = hl->get_vals,
+			.ctx = hl->ctx,
+		};
+		for (i = 0; i < n; ++i)
+			cstump_raw_get_z(&items[miss_id[i]]->seg,
+					 population[miss_id[i]], sp_m, samples,
+					 label, D, &opt_hl);
 	}
+	// 重复个体（包括同一代内的重复个体）与首次出现的个体共用表项
+	for (i = 0; i < m; ++i)
+		vals[i] = items[i]->seg.z;
+}
+
+bool cache_init(struct fit_cache *cache, size_t size, size_t n)
+{
+	const size_t align = _Alignof(struct fit_item);
+	size_t len = 1;
+	while (len < 2 * n)	// 装载因子不超过 1/2，保证表不会被填满
+		len <<= 1;
+	cache->size = size;
+	cache->stride = (sizeof(struct fit_item) + size + align - 1) / align *
+	    align;
+	cache->mask = len - 1;
+	cache->items = calloc(len, cache->stride);
+	return cache->items != NULL;
+}
+
+struct fit_item *cache_get(struct fit_cache *cache, const void *key,
+			   bool *found)
+{
+	// FNV-1a 哈希
+	size_t hash = 14695981039346656037ULL;
+	const unsigned char *bytes = key;
+	for (size_t i = 0; i < cache->size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	struct fit_item *item;
+	for (size_t i = hash & cache->mask;; i = (i + 1) & cache->mask) {
+		item = (struct fit_item *)(cache->items + i * cache->stride);
+		if (!item->used) {
+			item->used = true;
+			memcpy(item->key, key, cache->size);
+			*found = false;
+			return item;
+		}
+		if (memcmp(item->key, key, cache->size) == 0) {
+			*found = true;
+			return item;
+		}
+	}
+}
+
+void cache_free(struct fit_cache *cache)
+{
+	free(cache->items);
+}
+
+void archive_push(struct stump_ga_archive *archive, const void *individual,
+		  size_t size)
+{
+	if (archive->items == NULL) {
+		archive->items = malloc(size * archive->cap);
+		if (archive->items == NULL)
+			return;
+		archive->size = size;
+	}
+	if (archive->size != size)
+		return;
+	for (num_t i = 0; i < archive->n; ++i)
+		if (memcmp(archive->items + i * size, individual, size) == 0)
+			return;
+
+	memcpy(archive->items + archive->next * size, individual, size);
+	archive->next = (archive->next + 1) % archive->cap;
+	if (archive->n < archive->cap)
+		++archive->n;
+}
+
+flt_t elapsed(const struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) +
+	    (now.tv_nsec - start->tv_nsec) / 1E9;
 }
 
 // 获取数组最小值的索引
@@ -164,44 +391,81 @@ num_t argmin(flt_t vals[], num_t m)
 	return min_id;
 }
 
-bool ga(void *opt, size_t ft_size, num_t m, const void *samples,
-	const label_t * label, const flt_t * D,
+bool ga(void *opt, struct cstump_segment *seg, size_t ft_size, num_t m,
+	const void *samples, const label_t * label, const flt_t * D,
 	const struct stump_ga_handles *handles)
 {
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	struct fit_cache cache;
+	if (!cache_init(&cache, ft_size, (size_t)handles->m *
+			(handles->gen + 1)))
+		return false;
 	unsigned char (*population)[ft_size] = malloc(ft_size * handles->m);
 	unsigned char (*children)[ft_size] = malloc(ft_size * handles->m);
-	if (population == NULL || children == NULL) {
+	unsigned char (*miss)[ft_size] = NULL;	// 缓存未命中的个体
+	sample_t (*batch)[m] = NULL;	// 种群取值矩阵
+	if (handles->get_batch != NULL) {
+		miss = malloc(ft_size * handles->m);
+		batch = malloc(sizeof(sample_t) * m * handles->m);
+	}
+	if (population == NULL || children == NULL
+	    || (handles->get_batch != NULL && (miss == NULL || batch == NULL))) {
 		free(population);
 		free(children);
+		free(miss);
+		free(batch);
+		cache_free(&cache);
 		return false;
 	}
 
+	bool found;
 	flt_t vals_p[handles->m];	// 父代适应值
 	flt_t vals_c[handles->m];	// 子代适应值
 	init_pop(handles->m, ft_size, population, samples, handles);
 	fit_val(vals_p, m, samples, label, D, handles->m, ft_size, population,
-		handles);
+		&cache, batch, miss, handles);
 
 	num_t id = argmin(vals_p, handles->m);
 	flt_t min_val = vals_p[id];	// 历史最优值
+	num_t stall = 0;		// 历史最优值连续未改进的代数
+	unsigned char best[ft_size];	// 历史最优个体
+	memcpy(best, population[id], ft_size);
 	handles->update_opt(opt, population[id]);
+	*seg = cache_get(&cache, population[id], &found)->seg;
 	for (num_t t = 0; t < handles->gen; ++t) {
+		// 提前终止：长时间未改进或超出时间上限
+		if (handles->stall_gen > 0 && stall >= handles->stall_gen)
+			break;
+		if (handles->time_limit > 0
+		    && elapsed(&start) >= handles->time_limit)
+			break;
 		crossover(handles->m, ft_size, children, population, samples,
 			  handles);
 		mutation(handles->m, ft_size, children, samples, handles);
 		fit_val(vals_c, m, samples, label, D, handles->m, ft_size,
-			children, handles);
+			children, &cache, batch, miss, handles);
 		select_pop(handles->m, ft_size, population, vals_p, children,
 			   vals_c);
 		id = argmin(vals_p, handles->m);
 		// 更新历史最优值
 		if (min_val > vals_p[id]) {
 			min_val = vals_p[id];
+			memcpy(best, population[id], ft_size);
 			handles->update_opt(opt, population[id]);
+			*seg = cache_get(&cache, population[id], &found)->seg;
+			stall = 0;
+		} else {
+			++stall;
 		}
 	}
+	if (handles->archive != NULL)
+		archive_push(handles->archive, best, ft_size);
 
 	free(population);
 	free(children);
+	free(miss);
+	free(batch);
+	cache_free(&cache);
 	return true;
 }
@@ -19,6 +19,25 @@ typedef void (*ga_crossover_fn)(void *child, const void *parent1,
 				const void *parent2, const void *samples);
 /// 回调函数类型：对单个个体进行变异操作
 typedef void (*ga_mutate_fn)(void *individual, const void *samples);
+/**
+ * \brief 回调函数类型：以样本为主序，批量计算样本集在种群各个体上的取值
+ * \param[in] m        样本数量
+ * \param[in] n        个体数量
+ * \param[in] ft_size  单个个体的长度（字节）
+ * \param[out] vals    n * m 大小的矩阵，vals[j][i] 保存第 i 个样本在第 j 个
+ *      个体上的取值
+ * \param[in] features 连续存放的 n 个个体
+ * \param[in] samples  指向用户定义的样本集
+ */
+typedef void (*ga_get_batch_fn)(num_t m, num_t n, size_t ft_size,
+				sample_t vals[n][m], const void *features,
+				const void *samples);
+
+/**
+ * \brief 精英个体档案：跨多次训练保存各轮的最优个体，用于热启动新种群。
+ * 	内部为环形缓冲区，容量满后覆盖最早的个体
+ */
+struct stump_ga_archive;
 
 /// 使用进化算法寻找决策树桩划分属性的回调函数集
 struct stump_ga_handles {
@@ -26,11 +45,26 @@ struct stump_ga_handles {
 	num_t m;			///< 种群数量
 	flt_t p_c;			///< 交叉概率
 	flt_t p_m;			///< 变异概率
+	num_t stall_gen;		///< 历史最优值连续 stall_gen 代未改进时提前
+					/**< 终止；为 0 时不启用 */
+	flt_t time_limit;		///< 运行时间上限（秒）；为 0 时不限
+	struct stump_ga_archive *archive;	///< 精英个体档案，可置为 NULL
+	flt_t seed_ratio;		///< 初始种群中由档案个体产生的比例
 	ga_init_fn init;		///< 初始化函数
 	ga_crossover_fn crossover;	///< 交叉函数
 	ga_mutate_fn mutate;		///< 变异函数
 	st_get_vals_fn get_vals;	///< 回调函数，返回样本集在某特征上的取值
+	ga_get_batch_fn get_batch;	///< 回调函数，批量计算种群上的取值
+					/**< 可置为 NULL，此时逐个体调用 get_vals */
 	st_update_opt_fn update_opt;	///< 回调函数，更新划分属性
+	struct train_ctx *ctx;		///< 训练上下文（选择交叉、变异个体），可为
+					/**< NULL */
+};
+
+/// 进化算法适应值缓存的统计信息（用于调整 GEN、POP_SIZE 等参数）
+struct stump_ga_stat {
+	unsigned long lookup;		///< 适应值查询次数（即个体评估次数）
+	unsigned long hit;		///< 缓存命中次数（重复个体，无需重新计算）
 };
 
 /*******************************************************************************
@@ -62,4 +96,29 @@ bool cstump_cf_ga(struct cstump_cf_base *stump, void *opt, size_t ft_size,
 		  num_t m, const void *samples, const label_t * label,
 		  const flt_t * D, const struct stump_ga_handles *handles);
 
+/**
+ * \brief 获取进化算法适应值缓存的统计信息（自上次重置以来的累计值）。
+ * 	统计信息为进程内所有训练共用，以原子操作更新，并行训练时为各训练之和
+ * \param[out] stat 用于保存统计信息
+ */
+void stump_ga_get_stat(struct stump_ga_stat *stat);
+
+/**
+ * \brief 重置进化算法适应值缓存的统计信息
+ */
+void stump_ga_reset_stat(void);
+
+/**
+ * \brief 创建精英个体档案
+ * \param[in] cap 档案最多保存的个体数量
+ * \return 成功则返回档案地址，失败则返回 NULL
+ */
+struct stump_ga_archive *stump_ga_archive_new(num_t cap);
+
+/**
+ * \brief 释放精英个体档案
+ * \param[in] archive 由 stump_ga_archive_new() 创建的档案，可以为 NULL
+ */
+void stump_ga_archive_free(struct stump_ga_archive *archive);
+
 #endif
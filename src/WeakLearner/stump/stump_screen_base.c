@@ -0,0 +1,249 @@
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include "stump_screen_base.h"
+#include "stump_base_pvt.h"
+#include "atomic_pvt.h"
+/**
+ * \file stump_screen_base.c
+ * \brief stump_base 训练方法重载，两阶段寻优（函数实现）
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-07-13
+ */
+
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 候选特征集：以子样本集 Z 值为键的大顶堆，堆顶为当前最差的候选特征
+struct candidates {
+	num_t n;			///< 候选特征数量
+	num_t cap;			///< 最多保存的候选特征数量
+	size_t size;			///< 单个特征的长度（字节）
+	flt_t *z;			///< 各候选特征在子样本集上的 Z/2 值
+	unsigned long *order;		///< 各候选特征的枚举次序
+	unsigned char *feats;		///< 候选特征数组
+};
+
+/*******************************************************************************
+ * 				    静态变量
+ ******************************************************************************/
+/// 两阶段寻优的统计信息
+static struct stump_screen_stat screen_stat;
+
+/*******************************************************************************
+ * 				  静态函数声明
+ ******************************************************************************/
+/// 初始化候选特征集，成功则返回真，失败则返回假
+static bool cand_init(struct candidates *cand, num_t cap, size_t size);
+/// 释放候选特征集
+static void cand_free(struct candidates *cand);
+/// 交换候选特征集中的两个元素
+static void cand_swap(struct candidates *cand, num_t i, num_t j);
+/// 比较两个候选特征的优劣：i 比 j 更差时返回真（Z 值相同时枚举次序靠后者更差）
+static bool cand_worse(const struct candidates *cand, num_t i, num_t j);
+/// 尝试将特征加入候选特征集（集合已满时替换掉最差的候选特征）
+static void cand_push(struct candidates *cand, const void *feature, flt_t z,
+		      unsigned long order);
+
+/**
+ * \brief 两阶段寻优框架
+ * \param[out] opt  用于保存所选特征
+ * \param[out] seg  用于保存所选特征在完整样本集上的最优划分
+ * \details 其余参数同 cstump_screen_opt()
+ * \return 成功则返回真，失败则返回假
+ */
+static bool screen_opt(void *opt, struct cstump_segment *seg, size_t ft_size,
+		       num_t m, const void *samples, const label_t * label,
+		       const flt_t * D, const struct stump_opt_handles *handles,
+		       const struct stump_screen *screen);
+
+/*******************************************************************************
+ * 				    函数定义
+ ******************************************************************************/
+bool cstump_screen_opt(struct cstump_base *stump, void *opt, size_t ft_size,
+		       num_t m, const void *samples, const label_t * label,
+		       const flt_t * D, const struct stump_opt_handles *handles,
+		       const struct stump_screen *screen)
+{
+	struct cstump_segment seg;
+	if (!screen_opt(opt, &seg, ft_size, m, samples, label, D, handles,
+			screen))
+		return false;
+
+	cstump_update(stump, &seg);
+	return true;
+}
+
+bool cstump_cf_screen_opt(struct cstump_cf_base *stump, void *opt,
+			  size_t ft_size, num_t m, const void *samples,
+			  const label_t * label, const flt_t * D,
+			  const struct stump_opt_handles *handles,
+			  const struct stump_screen *screen)
+{
+	struct cstump_segment seg;
+	if (!screen_opt(opt, &seg, ft_size, m, samples, label, D, handles,
+			screen))
+		return false;
+
+	cstump_cf_update(stump, &seg);
+	return true;
+}
+
+void stump_screen_get_stat(struct stump_screen_stat *stat)
+{
+	stat->round = ATOMIC_LOAD(screen_stat.round);
+	stat->checked = ATOMIC_LOAD(screen_stat.checked);
+	stat->hit = ATOMIC_LOAD(screen_stat.hit);
+	stat->z_loss = ATOMIC_LOAD(screen_stat.z_loss);
+}
+
+void stump_screen_reset_stat(void)
+{
+	ATOMIC_STORE(screen_stat.round, 0);
+	ATOMIC_STORE(screen_stat.checked, 0);
+	ATOMIC_STORE(screen_stat.hit, 0);
+	ATOMIC_STORE(screen_stat.z_loss, 0);
+}
+
+/*******************************************************************************
+ * 				  静态函数实现
+ ******************************************************************************/
+bool cand_init(struct candidates *cand, num_t cap, size_t size)
+{
+	cand->n = 0;
+	cand->cap = cap;
+	cand->size = size;
+	cand->z = malloc(sizeof(flt_t) * cap);
+	cand->order = malloc(sizeof(unsigned long) * cap);
+	cand->feats = malloc(size * cap);
+	if (cand->z == NULL || cand->order == NULL || cand->feats == NULL) {
+		cand_free(cand);
+		return false;
+	}
+	return true;
+}
+
+void cand_free(struct candidates *cand)
+{
+	free(cand->z);
+	free(cand->order);
+	free(cand->feats);
+}
+
+void cand_swap(struct candidates *cand, num_t i, num_t j)
+{
+	unsigned char tmp[cand->size];
+	memcpy(tmp, cand->feats + i * cand->size, cand->size);
+	memcpy(cand->feats + i * cand->size, cand->feats + j * cand->size,
+	       cand->size);
+	memcpy(cand->feats + j * cand->size, tmp, cand->size);
+
+	flt_t z = cand->z[i];
+	cand->z[i] = cand->z[j];
+	cand->z[j] = z;
+	unsigned long order = cand->order[i];
+	cand->order[i] = cand->order[j];
+	cand->order[j] = order;
+}
+
+bool cand_worse(const struct candidates *cand, num_t i, num_t j)
+{
+	if (cand->z[i] != cand->z[j])
+		return cand->z[i] > cand->z[j];
+	return cand->order[i] > cand->order[j];
+}
+
+void cand_push(struct candidates *cand, const void *feature, flt_t z,
+	       unsigned long order)
+{
+	num_t i;
+	if (cand->n < cand->cap) {
+		// 插入到堆尾并上浮
+		i = cand->n++;
+		memcpy(cand->feats + i * cand->size, feature, cand->size);
+		cand->z[i] = z;
+		cand->order[i] = order;
+		for (; i > 0 && cand_worse(cand, i, (i - 1) / 2); i = (i - 1) / 2)
+			cand_swap(cand, i, (i - 1) / 2);
+		return;
+	}
+
+	// 不优于堆顶（枚举次序总是靠后）则舍弃，否则替换堆顶并下沉
+	if (z >= cand->z[0])
+		return;
+	memcpy(cand->feats, feature, cand->size);
+	cand->z[0] = z;
+	cand->order[0] = order;
+	for (i = 0;;) {
+		num_t worst = i;
+		num_t l = 2 * i + 1, r = 2 * i + 2;
+		if (l < cand->n && cand_worse(cand, l, worst))
+			worst = l;
+		if (r < cand->n && cand_worse(cand, r, worst))
+			worst = r;
+		if (worst == i)
+			break;
+		cand_swap(cand, i, worst);
+		i = worst;
+	}
+}
+
+bool screen_opt(void *opt, struct cstump_segment *seg, size_t ft_size,
+		num_t m, const void *samples, const label_t * label,
+		const flt_t * D, const struct stump_opt_handles *handles,
+		const struct stump_screen *screen)
+{
+	typeof(&cstump_raw_get_z) get_z = (handles->get_vals.sort == NULL) ?
+	    cstump_raw_get_z : cstump_sort_get_z;
+	struct candidates cand;
+	if (!cand_init(&cand, screen->top_k, ft_size))
+		return false;
+
+	// 第一阶段：在子样本集上枚举所有特征，保留 Z 值最小的 top_k 个特征
+	unsigned char feature[ft_size];
+	struct cstump_segment cur;
+	unsigned long order = 0;
+	handles->init_feature(feature, screen->sub_samples);
+	do {
+		get_z(&cur, feature, screen->sub_m, screen->sub_samples,
+		      screen->sub_label, screen->sub_D, handles);
+		cand_push(&cand, feature, cur.z, order++);
+	} while (handles->next_feature(feature, screen->sub_samples));
+
+	// 第二阶段：在完整样本集上精确计算候选特征，Z 值相同时取枚举次序靠前者
+	num_t best = 0;
+	unsigned long best_order = 0;
+	seg->z = DBL_MAX;
+	for (num_t i = 0; i < cand.n; ++i) {
+		const unsigned char *ptr = cand.feats + i * ft_size;
+		get_z(&cur, ptr, m, samples, label, D, handles);
+		if (cur.z < seg->z
+		    || (cur.z == seg->z && cand.order[i] < best_order)) {
+			*seg = cur;
+			best = i;
+			best_order = cand.order[i];
+		}
+	}
+	handles->update_opt(opt, cand.feats + best * ft_size);
+	ATOMIC_ADD(screen_stat.round, 1);
+
+	// 诊断：完整枚举，统计最优特征是否位于候选特征中
+	if (screen->check) {
+		flt_t min_z = DBL_MAX;
+		handles->init_feature(feature, samples);
+		do {
+			get_z(&cur, feature, m, samples, label, D, handles);
+			if (cur.z < min_z)
+				min_z = cur.z;
+		} while (handles->next_feature(feature, samples));
+		ATOMIC_ADD(screen_stat.checked, 1);
+		if (seg->z <= min_z)
+			ATOMIC_ADD(screen_stat.hit, 1);
+		else
+			ATOMIC_ADD_FLT(screen_stat.z_loss, seg->z - min_z);
+	}
+
+	cand_free(&cand);
+	return true;
+}
@@ -0,0 +1,80 @@
+#ifndef STUMP_SCREEN_BASE_H
+#define STUMP_SCREEN_BASE_H
+#include "stump_base.h"
+/**
+ * \file stump_screen_base.h
+ * \brief stump_base 训练方法重载，两阶段寻优：先在子样本集上筛选候选特征，再
+ * 	在完整样本集上精确计算候选特征（函数声明）
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-07-13
+ */
+
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 两阶段寻优的设置
+struct stump_screen {
+	num_t top_k;			///< 进入精确计算阶段的候选特征数量
+	num_t sub_m;			///< 子样本数量
+	const void *sub_samples;	///< 子样本集（与完整样本集同类型）
+	const label_t *sub_label;	///< 子样本集标签
+	const flt_t *sub_D;		///< 子样本集的概率分布
+	bool check;			///< 是否同时在完整样本集上枚举所有特征，
+					/**< 以统计筛选的命中率（仅用于诊断） */
+};
+
+/// 两阶段寻优的统计信息（用于调整候选特征数量、子样本数量）
+struct stump_screen_stat {
+	unsigned long round;		///< 寻优次数
+	unsigned long checked;		///< 进行了完整枚举校验的次数
+	unsigned long hit;		///< 完整枚举的最优特征位于候选特征中的次数
+	flt_t z_loss;			///< 筛选所得 Z/2 值与最优 Z/2 值之差的累计
+};
+
+/*******************************************************************************
+ * 				    函数声明
+ ******************************************************************************/
+/**
+ * \brief 两阶段获取 cstump_base 类型决策树桩的划分属性（不保证得到最优划分
+ *      属性）：先在子样本集上计算所有特征的 Z 值，保留 Z 值最小的 top_k 个特
+ *      征；再在完整样本集上计算这些特征的 Z 值，从中选出最优者
+ * \param[out] stump  未初始化的决策树桩
+ * \param[out] opt    用于保存最优划分属性的变量地址
+ * \param[in] ft_size 单个属性变量的长度（字节），即特征类型的长度
+ * \param[in] m       样本数量
+ * \param[in] samples 指向样本集的指针
+ * \param[in] label   指向标签集的指针
+ * \param[in] D       样本集的概率分布
+ * \param[in] handles 已初始化的回调函数集合（同时用于样本集及子样本集）
+ * \param[in] screen  两阶段寻优的设置
+ * \return 成功则返回真，失败则返回假
+ */
+bool cstump_screen_opt(struct cstump_base *stump, void *opt, size_t ft_size,
+		       num_t m, const void *samples, const label_t * label,
+		       const flt_t * D, const struct stump_opt_handles *handles,
+		       const struct stump_screen *screen);
+
+/**
+ * \brief 两阶段获取 cstump_cf_base 类型决策树桩的划分属性
+ * \details \copydetails cstump_screen_opt()
+ */
+bool cstump_cf_screen_opt(struct cstump_cf_base *stump, void *opt,
+			  size_t ft_size, num_t m, const void *samples,
+			  const label_t * label, const flt_t * D,
+			  const struct stump_opt_handles *handles,
+			  const struct stump_screen *screen);
+
+/**
+ * \brief 获取两阶段寻优的统计信息（自上次重置以来的累计值）。统计信息为
+ * 	进程内所有训练共用，以原子操作更新，并行训练时为各训练之和
+ * \param[out] stat 用于保存统计信息
+ */
+void stump_screen_get_stat(struct stump_screen_stat *stat);
+
+/**
+ * \brief 重置两阶段寻优的统计信息
+ */
+void stump_screen_reset_stat(void);
+
+#endif
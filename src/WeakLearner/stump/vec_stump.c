@@ -52,13 +52,13 @@ struct sp_wrap {
  * \param[in] fun_opt: 基类选择最优划分属性函数的函数名，如 cstump_opt、cstump_cf_opt 等等
  * \details \copydetails vec_cstump_train()
  */
-#define TRAIN(stump, m, n, X, Y, D, cache, stump_type, fun_opt)			\
+#define TRAIN(stump, m, n, X, Y, D, cache, ctx, stump_type, fun_opt)		\
 ({										\
  	bool status;								\
 	do {									\
 		struct sp_wrap sp;						\
 		struct stump_opt_handles handles;				\
-		if (!init_train(&sp, &handles, stump, X, m, n, cache)) {	\
+		if (!init_train(&sp, &handles, stump, X, m, n, cache, ctx)) {	\
 			status = false;						\
 			break;							\
 		}								\
@@ -71,6 +71,34 @@ struct sp_wrap {
 	status;									\
 })
 
+/**
+ * 多标签训练模板
+ * \param[in] stump_type: 即 stump 实际上的类型
+ * \param[in] fun_opt: 基类的多标签最优划分属性函数的函数名，如
+ * 	cstump_multi_opt
+ * \details \copydetails vec_cstump_multi_train()
+ */
+#define MULTI_TRAIN(stump, dim, m, n, X, Y, D, cache, ctx, stump_type,	\
+		    fun_opt)							\
+({										\
+ 	bool status;								\
+	do {									\
+		struct sp_wrap sp;						\
+		struct stump_opt_handles handles;				\
+		if (!init_train(&sp, &handles, stump, X, m, n, cache, ctx)) {	\
+			status = false;						\
+			break;							\
+		}								\
+										\
+		stump_type ptr_stump = stump;					\
+		status = fun_opt(&ptr_stump->base, &ptr_stump->feature,		\
+				 sizeof(dim_t), sizeof(*ptr_stump), dim, m,	\
+				 &sp, Y, D, &handles);				\
+		free_train (&sp, &handles);					\
+	} while (0);								\
+	status;									\
+})
+
 /*******************************************************************************
  * 				  静态函数声明
  ******************************************************************************/
@@ -106,11 +134,12 @@ static const num_t *get_vals_sort(num_t m, const void *samples,
  * \param[in] m        样本数量
  * \param[in] n        样本特征数量
  * \param[in] cache    缓存指针，缓存使用 vec_new_cache() 函数生成
+ * \param[in] ctx      训练上下文
  * \return 成功则返回真，失败则返回假
  */
 static bool init_train(struct sp_wrap *sp, struct stump_opt_handles *handles,
 		       const void *stump, const void *X, num_t m, dim_t n,
-		       const void *cache);
+		       const void *cache, struct train_ctx *ctx);
 
 /**
  * \brief 训练资源释放操作
@@ -124,30 +153,52 @@ static inline void free_train(struct sp_wrap *sp,
  * 				    函数实现
  ******************************************************************************/
 bool vec_cstump_train(void *stump, num_t m, dim_t n, const sample_t X[m][n],
-		      const label_t Y[], const flt_t D[], const void *cache)
+		      const label_t Y[], const flt_t D[], const void *cache,
+		      struct train_ctx *ctx)
 {
-	return TRAIN(stump, m, n, X, Y, D, cache, struct vec_cstump *,
+	return TRAIN(stump, m, n, X, Y, D, cache, ctx, struct vec_cstump *,
 		     cstump_opt);
 }
 
 bool vec_cstump_cf_train(void *stump, num_t m, dim_t n, const sample_t X[m][n],
-			 const label_t Y[], const flt_t D[], const void *cache)
+			 const label_t Y[], const flt_t D[], const void *cache,
+			 struct train_ctx *ctx)
 {
-	return TRAIN(stump, m, n, X, Y, D, cache, struct vec_cstump_cf *,
+	return TRAIN(stump, m, n, X, Y, D, cache, ctx, struct vec_cstump_cf *,
 		     cstump_cf_opt);
 }
 
+bool vec_cstump_multi_train(void *stump, mlabel_t dim, num_t m, dim_t n,
+			    const sample_t X[m][n], const label_t Y[],
+			    const flt_t D[], const void *cache,
+			    struct train_ctx *ctx)
+{
+	return MULTI_TRAIN(stump, dim, m, n, X, Y, D, cache, ctx,
+			   struct vec_cstump *, cstump_multi_opt);
+}
+
+bool vec_cstump_cf_multi_train(void *stump, mlabel_t dim, num_t m, dim_t n,
+			       const sample_t X[m][n], const label_t Y[],
+			       const flt_t D[], const void *cache,
+			       struct train_ctx *ctx)
+{
+	return MULTI_TRAIN(stump, dim, m, n, X, Y, D, cache, ctx,
+			   struct vec_cstump_cf *, cstump_cf_multi_opt);
+}
+
 bool vec_dstump_train(void *stump, num_t m, dim_t n, const sample_t X[m][n],
-		      const label_t Y[], const flt_t D[], const void *cache)
+		      const label_t Y[], const flt_t D[], const void *cache,
+		      struct train_ctx *ctx)
 {
-	return TRAIN(stump, m, n, X, Y, D, cache, struct vec_dstump *,
+	return TRAIN(stump, m, n, X, Y, D, cache, ctx, struct vec_dstump *,
 		     dstump_opt);
 }
 
 bool vec_dstump_cf_train(void *stump, num_t m, dim_t n, const sample_t X[m][n],
-			 const label_t Y[], const flt_t D[], const void *cache)
+			 const label_t Y[], const flt_t D[], const void *cache,
+			 struct train_ctx *ctx)
 {
-	return TRAIN(stump, m, n, X, Y, D, cache, struct vec_dstump_cf *,
+	return TRAIN(stump, m, n, X, Y, D, cache, ctx, struct vec_dstump_cf *,
 		     dstump_cf_opt);
 }
 
@@ -325,7 +376,7 @@ const num_t *get_vals_sort(num_t m, const void *samples, const void *feature)
 
 bool init_train(struct sp_wrap *sp, struct stump_opt_handles *handles,
 		const void *stump, const void *X, num_t m, dim_t n,
-		const void *cache)
+		const void *cache, struct train_ctx *ctx)
 {
 	const struct vec_cstump *cstump = stump;
 	sp->samples = X;
@@ -334,6 +385,7 @@ bool init_train(struct sp_wrap *sp, struct stump_opt_handles *handles,
 	handles->next_feature = next_feature;
 	handles->update_opt = update_opt;
 	handles->get_vals.raw = get_vals_raw;
+	handles->ctx = ctx;
 
 	if ((sp->vector = malloc(sizeof(sample_t) * m)) == NULL)
 		return false;
@@ -44,28 +44,50 @@ struct vec_dstump_cf {
  * \details \copydetails wl_train_vec_fn
  */
 bool vec_cstump_train(void *stump, num_t m, dim_t n, const sample_t X[m][n],
-		      const label_t Y[], const flt_t D[], const void *cache);
+		      const label_t Y[], const flt_t D[], const void *cache,
+		      struct train_ctx *ctx);
 
 /**
  * \brief vec_cstump_cf 决策树桩训练
  * \details \copydetails wl_train_vec_fn
  */
 bool vec_cstump_cf_train(void *stump, num_t m, dim_t n, const sample_t X[m][n],
-			 const label_t Y[], const flt_t D[], const void *cache);
+			 const label_t Y[], const flt_t D[], const void *cache,
+			 struct train_ctx *ctx);
+
+/**
+ * \brief vec_cstump 决策树桩多标签训练
+ * \details \copydetails wl_train_mvec_fn
+ */
+bool vec_cstump_multi_train(void *stump, mlabel_t dim, num_t m, dim_t n,
+			    const sample_t X[m][n], const label_t Y[],
+			    const flt_t D[], const void *cache,
+			    struct train_ctx *ctx);
+
+/**
+ * \brief vec_cstump_cf 决策树桩多标签训练
+ * \details \copydetails wl_train_mvec_fn
+ */
+bool vec_cstump_cf_multi_train(void *stump, mlabel_t dim, num_t m, dim_t n,
+			       const sample_t X[m][n], const label_t Y[],
+			       const flt_t D[], const void *cache,
+			       struct train_ctx *ctx);
 
 /**
  * \brief vec_dstump 决策树桩训练
  * \details \copydetails wl_train_vec_fn
  */
 bool vec_dstump_train(void *stump, num_t m, dim_t n, const sample_t X[m][n],
-		      const label_t Y[], const flt_t D[], const void *cache);
+		      const label_t Y[], const flt_t D[], const void *cache,
+		      struct train_ctx *ctx);
 
 /**
  * \brief vec_dstump_cf 决策树桩训练
  * \details \copydetails wl_train_vec_fn
  */
 bool vec_dstump_cf_train(void *stump, num_t m, dim_t n, const sample_t X[m][n],
-			 const label_t Y[], const flt_t D[], const void *cache);
+			 const label_t Y[], const flt_t D[], const void *cache,
+			 struct train_ctx *ctx);
 
 /**
  * \brief 获取 vec_cstump 决策树桩弱学习器的分类结果
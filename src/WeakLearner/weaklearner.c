@@ -3,6 +3,7 @@
 #include "stump/vec_stump.h"
 #include "stump/haar_stump.h"
 #include "stump/haar_stump_ga.h"
+#include "stump/stump_ga_base.h"
 /**
  * \file weaklearner.c
  * \brief 弱学习器函数调用集相关函数实现。
@@ -19,11 +20,16 @@ void wl_set_constant(struct wl_handles *handles)
 	handles->size = sizeof(constant);
 	handles->using_confident = false;
 	handles->hypothesis.vec = constant_h;
+	handles->hypothesis_std = NULL;
 	handles->train.vec = constant_train;
+	handles->train_mvec = NULL;
 	handles->read = NULL;
 	handles->write = NULL;
 	handles->copy = NULL;
 	handles->free = NULL;
+	handles->compile = NULL;
+	handles->param = NULL;
+	handles->ctx = NULL;
 }
 
 void wl_set_vec_cstump(struct wl_handles *handles)
@@ -31,11 +37,16 @@ void wl_set_vec_cstump(struct wl_handles *handles)
 	handles->size = sizeof(struct vec_cstump);
 	handles->using_confident = false;
 	handles->hypothesis.vec = vec_cstump_h;
+	handles->hypothesis_std = NULL;
 	handles->train.vec = vec_cstump_train;
+	handles->train_mvec = vec_cstump_multi_train;
 	handles->read = vec_cstump_read;
 	handles->write = vec_cstump_write;
 	handles->copy = NULL;
 	handles->free = NULL;
+	handles->compile = NULL;
+	handles->param = NULL;
+	handles->ctx = NULL;
 }
 
 void wl_set_vec_cstump_cf(struct wl_handles *handles)
@@ -43,11 +54,16 @@ void wl_set_vec_cstump_cf(struct wl_handles *handles)
 	handles->size = sizeof(struct vec_cstump_cf);
 	handles->using_confident = true;
 	handles->hypothesis.vec_cf = vec_cstump_cf_h;
+	handles->hypothesis_std = NULL;
 	handles->train.vec = vec_cstump_cf_train;
+	handles->train_mvec = vec_cstump_cf_multi_train;
 	handles->read = vec_cstump_cf_read;
 	handles->write = vec_cstump_cf_write;
 	handles->copy = NULL;
 	handles->free = NULL;
+	handles->compile = NULL;
+	handles->param = NULL;
+	handles->ctx = NULL;
 }
 
 void wl_set_vec_dstump(struct wl_handles *handles)
@@ -55,11 +71,16 @@ void wl_set_vec_dstump(struct wl_handles *handles)
 	handles->size = sizeof(struct vec_dstump);
 	handles->using_confident = false;
 	handles->hypothesis.vec = vec_dstump_h;
+	handles->hypothesis_std = NULL;
 	handles->train.vec = vec_dstump_train;
+	handles->train_mvec = NULL;
 	handles->read = vec_dstump_read;
 	handles->write = vec_dstump_write;
 	handles->copy = vec_dstump_copy;
 	handles->free = vec_dstump_free;
+	handles->compile = NULL;
+	handles->param = NULL;
+	handles->ctx = NULL;
 }
 
 void wl_set_vec_dstump_cf(struct wl_handles *handles)
@@ -67,58 +88,121 @@ void wl_set_vec_dstump_cf(struct wl_handles *handles)
 	handles->size = sizeof(struct vec_dstump_cf);
 	handles->using_confident = true;
 	handles->hypothesis.vec_cf = vec_dstump_cf_h;
+	handles->hypothesis_std = NULL;
 	handles->train.vec = vec_dstump_cf_train;
+	handles->train_mvec = NULL;
 	handles->read = vec_dstump_cf_read;
 	handles->write = vec_dstump_cf_write;
 	handles->copy = vec_dstump_cf_copy;
 	handles->free = vec_dstump_cf_free;
+	handles->compile = NULL;
+	handles->param = NULL;
+	handles->ctx = NULL;
 }
 
-void wl_set_haar(struct wl_handles *handles)
+void wl_set_haar(struct wl_handles *handles, const struct wl_opt_param *param)
 {
 	handles->size = sizeof(struct haar_stump);
 	handles->using_confident = false;
 	handles->hypothesis.haar = haar_stump_h;
+	handles->hypothesis_std = haar_stump_std_h;
 	handles->train.haar = haar_stump_train;
+	handles->train_mvec = NULL;
 	handles->read = NULL;
 	handles->write = NULL;
 	handles->copy = NULL;
 	handles->free = NULL;
+	handles->compile = haar_stump_compile;
+	handles->param = param;
+	handles->ctx = NULL;
 }
 
 // 将回调函数集设为 Haar 决策树桩，带置信度
-void wl_set_haar_cf(struct wl_handles *handles)
+void wl_set_haar_cf(struct wl_handles *handles,
+		    const struct wl_opt_param *param)
 {
 	handles->size = sizeof(struct haar_stump_cf);
 	handles->using_confident = true;
 	handles->hypothesis.haar_cf = haar_stump_cf_h;
+	handles->hypothesis_std = haar_stump_cf_std_h;
 	handles->train.haar = haar_stump_cf_train;
+	handles->train_mvec = NULL;
 	handles->read = NULL;
 	handles->write = NULL;
 	handles->copy = NULL;
 	handles->free = NULL;
+	handles->compile = haar_stump_cf_compile;
+	handles->param = param;
+	handles->ctx = NULL;
 }
 
-void wl_set_haar_ga(struct wl_handles *handles)
+void wl_set_haar_ga(struct wl_handles *handles,
+		    const struct wl_ga_param *param)
 {
 	handles->size = sizeof(struct haar_stump);
 	handles->using_confident = false;
 	handles->hypothesis.haar = haar_stump_h;
+	handles->hypothesis_std = haar_stump_std_h;
 	handles->train.haar = haar_stump_ga_train;
+	handles->train_mvec = NULL;
 	handles->read = NULL;
 	handles->write = NULL;
 	handles->copy = NULL;
 	handles->free = NULL;
+	handles->compile = haar_stump_compile;
+	handles->param = param;
+	handles->ctx = NULL;
 }
 
-void wl_set_haar_ga_cf(struct wl_handles *handles)
+void wl_set_haar_ga_cf(struct wl_handles *handles,
+		       const struct wl_ga_param *param)
 {
 	handles->size = sizeof(struct haar_stump_cf);
 	handles->using_confident = true;
 	handles->hypothesis.haar_cf = haar_stump_cf_h;
+	handles->hypothesis_std = haar_stump_cf_std_h;
 	handles->train.haar = haar_stump_ga_cf_train;
+	handles->train_mvec = NULL;
 	handles->read = NULL;
 	handles->write = NULL;
 	handles->copy = NULL;
 	handles->free = NULL;
+	handles->compile = haar_stump_cf_compile;
+	handles->param = param;
+	handles->ctx = NULL;
+}
+
+void wl_opt_param_default(struct wl_opt_param *param)
+{
+	param->top_k = 0;
+	param->sub_m = 0;
+	param->check = false;
+}
+
+void wl_ga_param_default(struct wl_ga_param *param)
+{
+	param->gen = GEN;
+	param->pop_size = POP_SIZE;
+	param->p_c = P_C;
+	param->p_m = P_M;
+	param->stall_gen = 0;
+	param->time_limit = 0;
+	param->archive = NULL;
+	param->seed_ratio = 0.25;
+}
+
+flt_t wl_haar_std_dev(imgsz_t h, imgsz_t w, imgsz_t wid,
+		      const sample_t x[h][wid], const sample_t x2[h][wid])
+{
+	return haar_stump_std_dev(h, w, wid, x, x2);
+}
+
+struct stump_ga_archive *wl_ga_archive_new(num_t cap)
+{
+	return stump_ga_archive_new(cap);
+}
+
+void wl_ga_archive_free(struct stump_ga_archive *archive)
+{
+	stump_ga_archive_free(archive);
 }
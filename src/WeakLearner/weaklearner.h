@@ -1,8 +1,10 @@
 #ifndef WEAKLEARNER_H
 #define WEAKLEARNER_H
 #include <stdio.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include "boost_cfg.h"
+#include "train_ctx.h"
 /**
  * \file weaklearner.h
  * \brief 弱学习器函数调用集定义及函数声明。
@@ -59,6 +61,20 @@ typedef flt_t(*wl_h_haar_cf_fn) (const void *stump, imgsz_t h, imgsz_t w,
 				 imgsz_t wid, const sample_t x[h][wid],
 				 const sample_t x2[h][wid], flt_t scale);
 
+/**
+ * \brief 回调函数类型：输出分类结果（窗口标准差由调用者给出，同一窗口的所有弱
+ * 	学习器共用一次计算；不带置信度的弱学习器输出 -1 或 +1）
+ * \param[in] stump   已训练完毕的决策树桩
+ * \param[in] wid     图像实际宽度
+ * \param[in] x       积分图（窗口左上角）
+ * \param[in] std_dev 窗口的标准差，见 wl_haar_std_dev()
+ * \param[in] scale   与训练图片相比的尺度放大倍数
+ * \return 输出分类结果
+ */
+typedef flt_t(*wl_h_haar_std_fn) (const void *stump, imgsz_t wid,
+				  const sample_t x[][wid], flt_t std_dev,
+				  flt_t scale);
+
 /**
  * \brief 回调函数类型：对样本进行训练（输入为样本向量构成的矩阵，成功则返回真）
  * \param[out] stump 未初始化的决策树桩
@@ -68,11 +84,34 @@ typedef flt_t(*wl_h_haar_cf_fn) (const void *stump, imgsz_t h, imgsz_t w,
  * \param[in] Y      样本对应标签（1 或 -1 构成的数组）
  * \param[in] D      样本概率分布
  * \param[in] cache  缓存指针，可使用 vec_new_cache() 创建
+ * \param[in, out] ctx 训练上下文（随机数状态等），为 NULL 时使用全局设置
  * \return 成功则返回真；失败则返回假
  */
 typedef bool (*wl_train_vec_fn)(void *stump, num_t m, dim_t n,
 				const sample_t X[m][n], const label_t Y[],
-				const flt_t D[], const void *cache);
+				const flt_t D[], const void *cache,
+				struct train_ctx *ctx);
+
+/**
+ * \brief 回调函数类型：多标签训练（输入为样本向量构成的矩阵）。一次训练 dim
+ * 	个弱学习器，第 l 个使用第 l 行标签及概率分布；各特征只扫描一次，同时
+ * 	更新所有标签的权重
+ * \param[out] stump 未初始化的弱学习器数组（dim 个，依次存放）
+ * \param[in] dim   标签数量
+ * \param[in] m     样本数量
+ * \param[in] n     样本特征数量
+ * \param[in] X     样本集
+ * \param[in] Y     样本标签（dim × m 数组，每行由 1 或 -1 构成）
+ * \param[in] D     样本概率分布（dim × m 数组）
+ * \param[in] cache 缓存指针，可使用 vec_new_cache() 创建；为 NULL 时每个特征
+ * 	临时排序一次
+ * \param[in, out] ctx 训练上下文，为 NULL 时使用默认上下文
+ * \return 成功则返回真；失败则返回假
+ */
+typedef bool (*wl_train_mvec_fn)(void *stump, mlabel_t dim, num_t m, dim_t n,
+				 const sample_t X[m][n], const label_t Y[],
+				 const flt_t D[], const void *cache,
+				 struct train_ctx *ctx);
 
 /**
  * \brief 回调函数类型：对样本进行训练（输入为样本的指针数组，每个样本用长度
@@ -85,12 +124,15 @@ typedef bool (*wl_train_vec_fn)(void *stump, num_t m, dim_t n,
  * \param[in] X2    灰度值平方的积分图数组（每个元素指向 h * w 大小的二维数组）
  * \param[in] Y     样本标签
  * \param[in] D     样本概率分布数组
+ * \param[in] param 训练参数（如 struct wl_ga_param *），为 NULL 时使用默认设置
+ * \param[in, out] ctx 训练上下文（随机数状态等），为 NULL 时使用全局设置
  * \return 成功则返回真，否则返回假
  */
 typedef bool (*wl_train_haar_fn)(void *stump, num_t m, imgsz_t h, imgsz_t w,
 				 const sample_t * const X[],
 				 const sample_t * const X2[], const label_t Y[],
-				 const flt_t D[]);
+				 const flt_t D[], const void *param,
+				 struct train_ctx *ctx);
 
 /**
  * \brief 回调函数类型：从文件中读取弱学习器
@@ -122,6 +164,34 @@ typedef void *(*wl_copy_fn)(void *dst, const void *src);
  */
 typedef void (*wl_free_fn)(void *stump);
 
+/// Haar 特征在积分图上的最大取值点数量
+#define WL_HAAR_TAPS 9
+
+/**
+ * \brief 编译后的 Haar 决策树桩：在给定尺度、给定图像宽度下，特征被展开为积分
+ * 	图上的偏移量及权重，尺度归一化并入划分值。设窗口左上角的积分图地址为 x、
+ * 	窗口标准差为 std，则矩形和 raw = Σ weight[k] * x[offset[k]]，输出为
+ * 	output[raw >= value * std]
+ */
+struct wl_haar_compiled {
+	num_t n;			///< 取值点数量
+	ptrdiff_t offset[WL_HAAR_TAPS];	///< 取值点相对窗口左上角的偏移（元素个数）
+	flt_t weight[WL_HAAR_TAPS];	///< 取值点的权重
+	flt_t value;			///< 划分值（已乘以尺度的平方）
+	flt_t output[2];		///< 小于、不小于划分值时的输出值
+};
+
+/**
+ * \brief 回调函数类型：在给定尺度、给定图像宽度下编译 Haar 决策树桩
+ * \param[out] dst  用于保存编译结果
+ * \param[in] stump 已训练完毕的决策树桩
+ * \param[in] wid   图像实际宽度
+ * \param[in] scale 与训练图片相比的尺度放大倍数
+ */
+typedef void (*wl_compile_haar_fn)(struct wl_haar_compiled *dst,
+				   const void *stump, imgsz_t wid,
+				   flt_t scale);
+
 /// 弱学习器回调函数集合
 struct wl_handles {
 	size_t size;		///< 弱学习器类型的大小（字节），
@@ -134,14 +204,52 @@ struct wl_handles {
 		wl_h_haar_fn haar;
 		wl_h_haar_cf_fn haar_cf;
 	} hypothesis;		///< 输出弱学习器分类结果
+	wl_h_haar_std_fn hypothesis_std;	///< 输出弱学习器分类结果（给定窗
+				/**< 口标准差），仅用于 Haar 决策树桩，否则为 NULL */
 	union {
 		wl_train_vec_fn vec;
 		wl_train_haar_fn haar;
 	} train;		///< 弱学习器训练
+	wl_train_mvec_fn train_mvec;	///< 多标签训练，不支持时为 NULL
 	wl_read_fn read;	///< 从文件中读取弱学习器
 	wl_write_fn write;	///< 将弱学习器写入到文件
 	wl_copy_fn copy;	///< 对弱学习器进行深度复制
 	wl_free_fn free;	///< 释放弱学习器内存空间
+	wl_compile_haar_fn compile;	///< 编译 Haar 决策树桩，不支持时为 NULL
+	const void *param;	///< 训练参数，传递给 train.haar()
+				/**< 为 NULL 时使用 boost_cfg.h 中的默认设置 */
+	struct train_ctx *ctx;	///< 训练上下文，传递给 train 及概率分布更新函数
+				/**< 为 NULL 时使用默认上下文 */
+};
+
+/**
+ * \brief 枚举训练参数（用于 Haar 决策树桩）。启用两阶段寻优时，先在按概率分
+ * 	布抽取的子样本集上计算所有特征，再在完整样本集上精确计算 Z 值最小的
+ * 	top_k 个候选特征（不保证得到最优特征）
+ */
+struct wl_opt_param {
+	num_t top_k;		///< 候选特征数量；为 0 时不启用两阶段寻优
+	num_t sub_m;		///< 子样本数量；不小于样本数量时不启用两阶段寻优
+	bool check;		///< 是否统计筛选的命中率（每轮额外进行一次完整枚
+				/**< 举，仅用于诊断，见 stump_screen_get_stat()）*/
+};
+
+struct stump_ga_archive;
+
+/// 进化算法训练参数（用于 Haar 决策树桩），可在运行时调整
+struct wl_ga_param {
+	num_t gen;		///< 最大迭代次数
+	num_t pop_size;		///< 种群大小
+	flt_t p_c;		///< 交叉概率
+	flt_t p_m;		///< 变异概率
+	num_t stall_gen;	///< 历史最优适应值连续 stall_gen 代未改进时提前
+				/**< 终止；为 0 时不启用 */
+	flt_t time_limit;	///< 训练单个弱学习器的时间上限（秒）；为 0 时不限
+	struct stump_ga_archive *archive;	///< 精英个体档案，为 NULL 时不启用
+				/**< 热启动。每次训练结束后保存最优个体，并以
+				 * 此产生下一次训练的部分初始种群；档案可在
+				 * 多轮、多级训练间共享（样本尺寸须相同） */
+	flt_t seed_ratio;	///< 初始种群中由档案个体产生的比例（0 ~ 1）
 };
 
 /*******************************************************************************
@@ -179,27 +287,72 @@ void wl_set_vec_dstump(struct wl_handles *handles);
 void wl_set_vec_dstump_cf(struct wl_handles *handles);
 
 /**
- * \brief 将回调函数集设为 Haar 决策树桩，不带置信度
- * \details \copydetails wl_set_constant()
+ * \brief 将回调函数集设为 Haar 决策树桩，枚举所有特征进行训练，不带置信度
+ * \param[out] handles 回调函数结构体地址
+ * \param[in] param    枚举训练参数，训练期间需保持有效；为 NULL 时枚举所有特
+ * 	征并在完整样本集上计算
  */
-void wl_set_haar(struct wl_handles *handles);
+void wl_set_haar(struct wl_handles *handles, const struct wl_opt_param *param);
 
 /**
- * \brief 将回调函数集设为 Haar 决策树桩，带置信度
- * \details \copydetails wl_set_constant()
+ * \brief 将回调函数集设为 Haar 决策树桩，枚举所有特征进行训练，带置信度
+ * \details \copydetails wl_set_haar()
  */
-void wl_set_haar_cf(struct wl_handles *handles);
+void wl_set_haar_cf(struct wl_handles *handles,
+		    const struct wl_opt_param *param);
 
 /**
  * \brief 将回调函数集设为 Haar 决策树桩，使用进化算法进行训练，不带置信度
- * \details \copydetails wl_set_constant()
+ * \param[out] handles 回调函数结构体地址
+ * \param[in] param    进化算法参数，训练期间需保持有效；为 NULL 时使用
+ * 	boost_cfg.h 中的默认设置
  */
-void wl_set_haar_ga(struct wl_handles *handles);
+void wl_set_haar_ga(struct wl_handles *handles,
+		    const struct wl_ga_param *param);
 
 /**
  * \brief 将回调函数集设为 Haar 决策树桩，使用进化算法进行训练，带置信度
- * \details \copydetails wl_set_constant()
+ * \details \copydetails wl_set_haar_ga()
+ */
+void wl_set_haar_ga_cf(struct wl_handles *handles,
+		       const struct wl_ga_param *param);
+
+/**
+ * \brief 计算窗口的标准差（用于 Haar 特征消除光照差异）
+ * \param[in] h   窗口高度
+ * \param[in] w   窗口宽度
+ * \param[in] wid 图像实际宽度
+ * \param[in] x   积分图（h * w 大小的二维数组）
+ * \param[in] x2  灰度值平方的积分图（h * w 大小的二维数组）
+ * \return 返回窗口的标准差；方差为 0 时返回 0
+ */
+flt_t wl_haar_std_dev(imgsz_t h, imgsz_t w, imgsz_t wid,
+		      const sample_t x[h][wid], const sample_t x2[h][wid]);
+
+/**
+ * \brief 初始化枚举训练参数，不启用两阶段寻优
+ * \param[out] param 要初始化的参数
+ */
+void wl_opt_param_default(struct wl_opt_param *param);
+
+/**
+ * \brief 使用 boost_cfg.h 中的默认设置（GEN、POP_SIZE、P_C、P_M）初始化进化算
+ * 	法参数，不启用提前终止、时间限制及热启动
+ * \param[out] param 要初始化的参数
+ */
+void wl_ga_param_default(struct wl_ga_param *param);
+
+/**
+ * \brief 创建进化算法的精英个体档案，用于 struct wl_ga_param 的 archive 成员
+ * \param[in] cap 档案最多保存的个体数量
+ * \return 成功则返回档案地址，失败则返回 NULL
+ */
+struct stump_ga_archive *wl_ga_archive_new(num_t cap);
+
+/**
+ * \brief 释放进化算法的精英个体档案
+ * \param[in] archive 由 wl_ga_archive_new() 创建的档案，可以为 NULL
  */
-void wl_set_haar_ga_cf(struct wl_handles *handles);
+void wl_ga_archive_free(struct stump_ga_archive *archive);
 
 #endif
@@ -110,7 +110,7 @@ void ada_set_mvec(struct mvec_ada_handles *handles, enum ada_mvec_t mvec_type,
  * 			   haar_ada_handles 函数声明
  ******************************************************************************/
 void ada_set_haar(struct haar_ada_handles *handles, enum ada_haar_t haar_type,
-		  enum ada_wl_train_t wl_train_type)
+		  enum ada_wl_train_t wl_train_type, const void *param)
 {
 	extern haar_ada_train_fn haar_ada_train_arr[ADA_HAAR_END];
 
@@ -119,18 +119,22 @@ void ada_set_haar(struct haar_ada_handles *handles, enum ada_haar_t haar_type,
 	case ADA_NM_APPROX:
 	case ADA_NM_NEWTON:
 		handles->h = haar_ada_h;
+		handles->h_std = haar_ada_std_h;
+		handles->compile = haar_ada_compile;
 		if (wl_train_type == ADA_OPT)
-			wl_set_haar(&handles->wl_hl);
+			wl_set_haar(&handles->wl_hl, param);
 		else
-			wl_set_haar_ga(&handles->wl_hl);
+			wl_set_haar_ga(&handles->wl_hl, param);
 		break;
 	case ADA_ASYM:
 	case ADA_ASYM_IMP:
 		handles->h = haar_ada_fold_h;
+		handles->h_std = haar_ada_fold_std_h;
+		handles->compile = haar_ada_fold_compile;
 		if (wl_train_type == ADA_OPT)
-			wl_set_haar_cf(&handles->wl_hl);
+			wl_set_haar_cf(&handles->wl_hl, param);
 		else
-			wl_set_haar_ga_cf(&handles->wl_hl);
+			wl_set_haar_ga_cf(&handles->wl_hl, param);
 	case ADA_HAAR_END:
 		break;
 	}
@@ -232,13 +232,29 @@ typedef bool (*haar_ada_train_fn)(struct haar_adaboost * adaboost, flt_t * d,
  * \param[in] x2       灰度值平方的积分图
  * \param[in] scale    与训练图片相比的尺度放大倍数
  * \param[in] handles  弱学习器回调函数集合
- * \return 输出分类结果（置信度）
+ * \return 输出分类结果（置信度）；小于 0 表示拒绝。若 AdaBoost 保存有软级联
+ * 	的拒绝阈值，部分和低于拒绝阈值时提前返回部分和与该阈值之差
  */
 typedef flt_t(*haar_ada_h_fn) (const struct haar_adaboost * adaboost,
 			       imgsz_t h, imgsz_t w, imgsz_t wid,
 			       const double x[h][wid], const double x2[h][wid],
 			       double scale, const struct wl_handles * handles);
 
+/**
+ * \brief 获取分类结果（窗口标准差由调用者给出，级联分类器的各级共用一次计算）
+ * \param[in] adaboost 已训练完毕的 AdaBoost 学习器；
+ * \param[in] wid      图像实际宽度
+ * \param[in] x        积分图（窗口左上角）
+ * \param[in] std_dev  窗口的标准差，见 wl_haar_std_dev()
+ * \param[in] scale    与训练图片相比的尺度放大倍数
+ * \param[in] handles  弱学习器回调函数集合（hypothesis_std 不可为 NULL）
+ * \return 输出分类结果（置信度），与 haar_ada_h_fn 相同
+ */
+typedef flt_t(*haar_ada_h_std_fn) (const struct haar_adaboost * adaboost,
+				   imgsz_t wid, const sample_t x[][wid],
+				   flt_t std_dev, flt_t scale,
+				   const struct wl_handles * handles);
+
 /**
  * \brief 从文件中读取 Adaboost
  * \param[out] adaboost 指向未初始化的 struct haar_adaboost 结构体
@@ -278,14 +294,31 @@ typedef void *(*haar_ada_copy_fn)(struct haar_adaboost * dst,
 typedef void (*haar_ada_free_fn)(struct haar_adaboost * adaboost,
 				 const struct wl_handles * handles);
 
+/**
+ * \brief 在给定尺度、给定图像宽度下编译所有弱学习器（用于检测）
+ * \param[out] dst     用于保存编译结果，长度不小于弱学习器数量；编译结果的输
+ * 	出值已乘以弱学习器系数，窗口的分类结果为各输出值之和减去阈值
+ * \param[in] adaboost 已训练完毕的 AdaBoost 学习器
+ * \param[in] wid      图像实际宽度
+ * \param[in] scale    与训练图片相比的尺度放大倍数
+ * \param[in] handles  弱学习器回调函数集合
+ * \return 成功则返回真；弱学习器不支持编译时返回假
+ */
+typedef bool (*haar_ada_compile_fn)(struct wl_haar_compiled dst[],
+				    const struct haar_adaboost * adaboost,
+				    imgsz_t wid, flt_t scale,
+				    const struct wl_handles * handles);
+
 /// 回调函数集定义
 struct haar_ada_handles {
 	haar_ada_train_fn train;	///< 训练方法
 	haar_ada_h_fn h;		///< 输出分类结果
+	haar_ada_h_std_fn h_std;	///< 输出分类结果（给定窗口标准差）
 	haar_ada_read_fn read;		///< 读取方法
 	haar_ada_write_fn write;	///< 写入方法
 	haar_ada_copy_fn copy;		///< 复制方法
 	haar_ada_free_fn free;		///< 内存释放方法
+	haar_ada_compile_fn compile;	///< 编译方法（用于检测）
 	struct wl_handles wl_hl;	///< 弱学习器的回调函数集合
 };
 
@@ -371,9 +404,14 @@ void ada_set_mvec(struct mvec_ada_handles *handles, enum ada_mvec_t mvec_type,
  * \param[out] handles: 要初始化的结构体
  * \param[in] haar_type: 指示训练方法
  * \param[in] wl_train_type: 指示弱学习器训练方法
+ * \param[in] param: 弱学习器训练参数，训练期间需保持有效；wl_train_type 为
+ * 	ADA_OPT 时，实际类型为 const struct wl_opt_param *；为 ADA_GA 时，实际
+ * 	类型为 const struct wl_ga_param *。为 NULL 时使用默认设置
+ * \note 训练上下文 handles->wl_hl.ctx 被置为 NULL（使用默认上下文
+ * 	train_ctx_default），需要时可在调用后设置
  */
 void ada_set_haar(struct haar_ada_handles *handles, enum ada_haar_t haar_type,
-		  enum ada_wl_train_t wl_train_type);
+		  enum ada_wl_train_t wl_train_type, const void *param);
 
 /**
  * 一个训练 AdaBoost 分类器的例子
@@ -28,7 +28,7 @@ enum ada_result ada_framework(void *adaboost, num_t m, const void *sample,
 	if ((vals = malloc(sizeof(flt_t) * handles->vals_len)) == NULL)
 		goto MEM_VALS_ERR;
 
-	handles->init_D(D, m, label);
+	handles->init_D(D, m, label, handles->ctx);
 	while (handles->next(&item, adaboost, vals, handles->vals_len) == true) {
 		if (!item.status || !handles->train(item.weaklearner, m,
 						    sample, label, D))
@@ -51,7 +51,7 @@ enum ada_result ada_framework(void *adaboost, num_t m, const void *sample,
 						 label, D);
 		// 更新样本分布
 		handles->update_D(D, vals, handles->vals_len, m, label,
-				  *item.alpha);
+				  *item.alpha, handles->ctx);
 	}
 
 	free(vals);
@@ -3,6 +3,7 @@
 #define ADABOOST_BASE_H
 #include <stdbool.h>
 #include "boost_cfg.h"
+#include "train_ctx.h"
 /**
  * \file adaboost_base.h
  * \brief Adaboost 分类器基类定义及函数声明
@@ -65,11 +66,13 @@ typedef bool (*ada_next_fn)(struct ada_item * item, void *adaboost,
 			    const flt_t vals[], num_t vals_len);
 
 /// 回调函数类型：初始化概率分布数组，保存到数组 D 中。
-typedef void (*ada_init_D_fn)(flt_t D[], num_t m, const void *label);
+typedef void (*ada_init_D_fn)(flt_t D[], num_t m, const void *label,
+			      const struct train_ctx *ctx);
 
 /// 更新概率分布数组，保存到数组 D 中
 typedef void (*ada_update_D_fn)(flt_t D[], flt_t vals[], num_t vals_len,
-				num_t m, const void *label, flt_t alpha);
+				num_t m, const void *label, flt_t alpha,
+				const struct train_ctx *ctx);
 
 /// 训练所用的回调函数集
 struct ada_handles {
@@ -81,6 +84,8 @@ struct ada_handles {
 	ada_next_fn next;		///< 下一弱学习器获取函数
 	ada_init_D_fn init_D;		///< 分布概率初始化函数
 	ada_update_D_fn update_D;	///< 分布概率函数更新函数
+	const struct train_ctx *ctx;	///< 训练上下文，传递给 init_D 及 update_D
+					/**< 可为 NULL */
 };
 
 /*******************************************************************************
@@ -0,0 +1,42 @@
+#ifndef ATOMIC_PVT_H
+#define ATOMIC_PVT_H
+/**
+ * \file atomic_pvt.h
+ * \brief 库内部共用的原子操作（GCC __atomic 内建函数，宽松内存序），用于多个
+ * 	线程同时更新的统计信息
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-08-05
+ */
+/*******************************************************************************
+ * 				    宏函数定义
+ ******************************************************************************/
+/// 原子地将 val 累加到整型变量 var
+#define ATOMIC_ADD(var, val) __atomic_fetch_add(&(var), (val), __ATOMIC_RELAXED)
+
+/// 原子地读取变量 var（整型或浮点型）
+#define ATOMIC_LOAD(var)							\
+({										\
+	__typeof__(var) atomic_val_;						\
+	__atomic_load(&(var), &atomic_val_, __ATOMIC_RELAXED);			\
+	atomic_val_;								\
+})
+
+/// 原子地将 val 写入变量 var（整型或浮点型）
+#define ATOMIC_STORE(var, val)							\
+({										\
+	__typeof__(var) atomic_val_ = (val);					\
+	__atomic_store(&(var), &atomic_val_, __ATOMIC_RELAXED);			\
+})
+
+/// 原子地将 val 累加到浮点型变量 var（比较并交换，失败时重试）
+#define ATOMIC_ADD_FLT(var, val)						\
+({										\
+	__typeof__(var) atomic_old_ = ATOMIC_LOAD(var);				\
+	__typeof__(var) atomic_add_ = (val);					\
+	while (!__atomic_compare_exchange(&(var), &atomic_old_,		\
+			&(__typeof__(var)) { atomic_old_ + atomic_add_ },	\
+			true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) ;		\
+})
+
+#endif
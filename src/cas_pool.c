@@ -0,0 +1,243 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include "cas_pool.h"
+
+/**
+ * \file cas_pool.c
+ * \brief 级联分类器并行检测所用的线程池（工作窃取）-- 函数实现
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-07-30
+ */
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 单个线程的任务队列：剩余任务编号为 [lo, hi)
+struct task_range {
+	pthread_mutex_t lock;		///< 互斥锁
+	size_t lo;			///< 下一个要执行的任务（线程自身从头部取出）
+	size_t hi;			///< 最后一个任务的下一编号（其他线程从尾部窃取）
+};
+
+/// 线程参数
+struct worker_arg {
+	struct cas_pool *pool;		///< 线程池
+	unsigned int id;		///< 线程编号
+};
+
+/// 常驻线程池
+struct cas_pool {
+	unsigned int threads;		///< 线程数量（包括调用者线程）
+	struct task_range *ranges;	///< 各线程的任务队列
+	pthread_t *tid;			///< 各工作线程（0 号为调用者线程，不使用）
+	struct worker_arg *warg;	///< 各线程的参数
+	cas_pool_fn fun;		///< 执行单个任务的回调函数
+	void *args;			///< 用户自定义参数
+	pthread_mutex_t lock;		///< 保护以下成员的互斥锁
+	pthread_cond_t start;		///< 新一批任务开始或线程池销毁
+	pthread_cond_t done;		///< 工作线程完成当前批次
+	unsigned long batch;		///< 批次编号，每批任务开始时加一
+	unsigned int busy;		///< 尚未完成当前批次的工作线程数量
+	bool quit;			///< 是否结束工作线程
+};
+
+/*******************************************************************************
+ * 				  静态函数声明
+ ******************************************************************************/
+/// 从线程自身的任务队列头部取出一个任务，队列为空时返回假
+static bool pop(struct task_range *range, size_t *task);
+
+/// 从其他线程窃取剩余任务的一半放入自身队列，无任务可窃取时返回假
+static bool steal(struct cas_pool *pool, unsigned int id);
+
+/// 执行当前批次：依次执行自身任务，完成后窃取其他线程的任务
+static void work(struct cas_pool *pool, unsigned int id);
+
+/// 工作线程入口：等待新一批任务并执行，直至线程池销毁
+static void *worker(void *arg);
+
+/*******************************************************************************
+ * 				    函数定义
+ ******************************************************************************/
+bool cas_pool_run(unsigned int threads, size_t n, cas_pool_fn fun, void *args)
+{
+	if (threads <= 1) {
+		for (size_t i = 0; i < n; ++i)
+			fun(i, 0, args);
+		return true;
+	}
+
+	struct cas_pool *pool = cas_pool_new(threads);
+	if (pool == NULL)
+		return false;
+	cas_pool_exec(pool, n, fun, args);
+	cas_pool_free(pool);
+	return true;
+}
+
+struct cas_pool *cas_pool_new(unsigned int threads)
+{
+	if (threads == 0)
+		threads = 1;
+	struct cas_pool *pool = malloc(sizeof(struct cas_pool));
+	if (pool == NULL)
+		return NULL;
+	pool->ranges = malloc(sizeof(struct task_range) * threads);
+	pool->tid = malloc(sizeof(pthread_t) * threads);
+	pool->warg = malloc(sizeof(struct worker_arg) * threads);
+	if (pool->ranges == NULL || pool->tid == NULL || pool->warg == NULL) {
+		free(pool->ranges);
+		free(pool->tid);
+		free(pool->warg);
+		free(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	pool->batch = 0;
+	pool->busy = 0;
+	pool->quit = false;
+	for (unsigned int i = 0; i < threads; ++i) {
+		pthread_mutex_init(&pool->ranges[i].lock, NULL);
+		pool->ranges[i].lo = pool->ranges[i].hi = 0;
+		pool->warg[i].pool = pool;
+		pool->warg[i].id = i;
+	}
+	// 0 号线程为调用者线程；线程创建失败时，线程池仅包含已创建的线程
+	for (pool->threads = 1; pool->threads < threads; ++pool->threads)
+		if (pthread_create(&pool->tid[pool->threads], NULL, worker,
+				   &pool->warg[pool->threads]) != 0)
+			break;
+	return pool;
+}
+
+unsigned int cas_pool_threads(const struct cas_pool *pool)
+{
+	return pool->threads;
+}
+
+void cas_pool_exec(struct cas_pool *pool, size_t n, cas_pool_fn fun,
+		   void *args)
+{
+	if (pool->threads == 1) {
+		for (size_t i = 0; i < n; ++i)
+			fun(i, 0, args);
+		return;
+	}
+
+	// 按编号连续分块分配任务（工作线程此时均在等待，由互斥锁保证可见性）
+	pthread_mutex_lock(&pool->lock);
+	for (unsigned int i = 0; i < pool->threads; ++i) {
+		pool->ranges[i].lo = n * i / pool->threads;
+		pool->ranges[i].hi = n * (i + 1) / pool->threads;
+	}
+	pool->fun = fun;
+	pool->args = args;
+	pool->busy = pool->threads - 1;
+	++pool->batch;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+
+	work(pool, 0);
+	pthread_mutex_lock(&pool->lock);
+	while (pool->busy > 0)
+		pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void cas_pool_free(struct cas_pool *pool)
+{
+	if (pool == NULL)
+		return;
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = true;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+	for (unsigned int i = 1; i < pool->threads; ++i)
+		pthread_join(pool->tid[i], NULL);
+
+	for (unsigned int i = 0; i < pool->threads; ++i)
+		pthread_mutex_destroy(&pool->ranges[i].lock);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->start);
+	pthread_cond_destroy(&pool->done);
+	free(pool->ranges);
+	free(pool->tid);
+	free(pool->warg);
+	free(pool);
+}
+
+/*******************************************************************************
+ * 				  静态函数实现
+ ******************************************************************************/
+bool pop(struct task_range *range, size_t *task)
+{
+	bool status = false;
+	pthread_mutex_lock(&range->lock);
+	if (range->lo < range->hi) {
+		*task = range->lo++;
+		status = true;
+	}
+	pthread_mutex_unlock(&range->lock);
+	return status;
+}
+
+bool steal(struct cas_pool *pool, unsigned int id)
+{
+	for (unsigned int k = 1; k < pool->threads; ++k) {
+		struct task_range *victim =
+		    &pool->ranges[(id + k) % pool->threads];
+		size_t lo, hi;
+		pthread_mutex_lock(&victim->lock);
+		hi = victim->hi;
+		lo = victim->lo + (victim->hi - victim->lo) / 2;
+		victim->hi = lo;
+		pthread_mutex_unlock(&victim->lock);
+		if (lo == hi)
+			continue;
+
+		struct task_range *self = &pool->ranges[id];
+		pthread_mutex_lock(&self->lock);
+		self->lo = lo;
+		self->hi = hi;
+		pthread_mutex_unlock(&self->lock);
+		return true;
+	}
+	return false;
+}
+
+void work(struct cas_pool *pool, unsigned int id)
+{
+	size_t task;
+	do {
+		while (pop(&pool->ranges[id], &task))
+			pool->fun(task, id, pool->args);
+	} while (steal(pool, id));
+}
+
+void *worker(void *arg)
+{
+	const struct worker_arg *warg = arg;
+	struct cas_pool *pool = warg->pool;
+	unsigned long batch = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->quit && pool->batch == batch)
+			pthread_cond_wait(&pool->start, &pool->lock);
+		if (pool->quit)
+			break;
+		batch = pool->batch;
+		pthread_mutex_unlock(&pool->lock);
+
+		work(pool, warg->id);
+
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->busy == 0)
+			pthread_cond_signal(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
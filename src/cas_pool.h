@@ -0,0 +1,75 @@
+#ifndef CAS_POOL_H
+#define CAS_POOL_H
+#include <stddef.h>
+#include <stdbool.h>
+/**
+ * \file cas_pool.h
+ * \brief 级联分类器并行检测所用的线程池（工作窃取）-- 函数声明。
+ * 	任务用 0 ~ n-1 的编号表示，初始时按编号连续分块分配给各线程；线程完成
+ * 	自身任务后，从其他线程剩余任务的尾部窃取一半，以平衡各任务耗时的差异
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-07-30
+ */
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/**
+ * \brief 回调函数类型：执行一个任务
+ * \param[in] task      任务编号
+ * \param[in] worker    执行任务的线程编号（0 ~ threads-1），可用于访问线程私
+ * 	有的缓冲区
+ * \param[in, out] args 用户自定义参数
+ */
+typedef void (*cas_pool_fn)(size_t task, unsigned int worker, void *args);
+
+/// 常驻线程池（不透明类型），工作线程在两批任务之间阻塞等待，可反复使用
+struct cas_pool;
+
+/*******************************************************************************
+ * 				    函数声明
+ ******************************************************************************/
+/**
+ * \brief 使用线程池执行 n 个任务，所有任务完成后返回
+ * \param[in] threads   线程数量（包括调用者线程），为 0 时视为 1
+ * \param[in] n         任务数量
+ * \param[in] fun       回调函数，执行单个任务（需保证可重入）
+ * \param[in, out] args 用户自定义参数，将被传递给 fun()
+ * \return 成功则返回真；无法初始化线程池时返回假，此时不执行任何任务。
+ * 	注：部分线程创建失败时，其任务由其他线程窃取执行，仍返回真
+ */
+bool cas_pool_run(unsigned int threads, size_t n, cas_pool_fn fun, void *args);
+
+/**
+ * \brief 创建常驻线程池（创建 threads-1 个工作线程，调用者线程为 0 号线程）
+ * \param[in] threads 线程数量（包括调用者线程），为 0 时视为 1
+ * \return 成功则返回线程池，否则返回 NULL。
+ * 	注：部分线程创建失败时，线程池仅包含已创建的线程，见 cas_pool_threads()
+ */
+struct cas_pool *cas_pool_new(unsigned int threads);
+
+/**
+ * \brief 获取线程池的实际线程数量（包括调用者线程）
+ * \param[in] pool cas_pool_new() 创建的线程池
+ * \return 返回线程数量，回调函数的线程编号小于该值
+ */
+unsigned int cas_pool_threads(const struct cas_pool *pool);
+
+/**
+ * \brief 使用常驻线程池执行 n 个任务（调用者线程同时参与执行），所有任务完成后
+ * 	返回；执行期间不申请内存、不创建线程。同一线程池不能被多个线程同时使用
+ * \param[in, out] pool cas_pool_new() 创建的线程池
+ * \param[in] n         任务数量
+ * \param[in] fun       回调函数，执行单个任务（需保证可重入）
+ * \param[in, out] args 用户自定义参数，将被传递给 fun()
+ */
+void cas_pool_exec(struct cas_pool *pool, size_t n, cas_pool_fn fun,
+		   void *args);
+
+/**
+ * \brief 结束工作线程并释放线程池
+ * \param[in] pool cas_pool_new() 创建的线程池，可以为 NULL
+ */
+void cas_pool_free(struct cas_pool *pool);
+
+#endif
@@ -0,0 +1,146 @@
+#include <time.h>
+#include "cas_profile.h"
+#include "atomic_pvt.h"
+/**
+ * \file cas_profile.c
+ * \brief 级联分类器检测过程的性能统计（函数实现）
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-08-02
+ */
+#ifdef CAS_PROFILE
+
+/*******************************************************************************
+ * 				    宏函数定义
+ ******************************************************************************/
+/// 级的统计下标，超出统计范围的级合并到最后一级
+#define STAGE(i) (((i) < CAS_PROF_STAGES) ? (i) : CAS_PROF_STAGES - 1)
+
+/*******************************************************************************
+ * 				    静态变量
+ ******************************************************************************/
+/// 检测过程的统计信息
+static struct cas_profile profile;
+
+/*******************************************************************************
+ * 				    函数定义
+ ******************************************************************************/
+void cas_profile_get(struct cas_profile *prof)
+{
+	num_t i;
+	// 检测线程可能同时在更新，逐字段原子地读取
+	prof->images = ATOMIC_LOAD(profile.images);
+	prof->windows = ATOMIC_LOAD(profile.windows);
+	prof->weak_learners = ATOMIC_LOAD(profile.weak_learners);
+	for (i = 0; i < CAS_PROF_SCALES; ++i) {
+		prof->scale_len[i] = ATOMIC_LOAD(profile.scale_len[i]);
+		prof->scale_windows[i] = ATOMIC_LOAD(profile.scale_windows[i]);
+	}
+	for (i = 0; i < CAS_PROF_STAGES; ++i) {
+		prof->stage_in[i] = ATOMIC_LOAD(profile.stage_in[i]);
+		prof->stage_pass[i] = ATOMIC_LOAD(profile.stage_pass[i]);
+	}
+	prof->raw_det = ATOMIC_LOAD(profile.raw_det);
+	prof->det = ATOMIC_LOAD(profile.det);
+	for (i = 0; i < CAS_PROF_PHASES; ++i)
+		prof->time[i] = ATOMIC_LOAD(profile.time[i]);
+}
+
+void cas_profile_reset(void)
+{
+	num_t i;
+	ATOMIC_STORE(profile.images, 0);
+	ATOMIC_STORE(profile.windows, 0);
+	ATOMIC_STORE(profile.weak_learners, 0);
+	for (i = 0; i < CAS_PROF_SCALES; ++i) {
+		ATOMIC_STORE(profile.scale_len[i], 0);
+		ATOMIC_STORE(profile.scale_windows[i], 0);
+	}
+	for (i = 0; i < CAS_PROF_STAGES; ++i) {
+		ATOMIC_STORE(profile.stage_in[i], 0);
+		ATOMIC_STORE(profile.stage_pass[i], 0);
+	}
+	ATOMIC_STORE(profile.raw_det, 0);
+	ATOMIC_STORE(profile.det, 0);
+	for (i = 0; i < CAS_PROF_PHASES; ++i)
+		ATOMIC_STORE(profile.time[i], 0);
+}
+
+bool cas_profile_dump(FILE * file)
+{
+	struct cas_profile snap;
+	const struct cas_profile *p = &snap;
+	num_t i, n;
+
+	cas_profile_get(&snap);
+
+	fprintf(file, "{\n  \"images\": %lu,\n  \"windows\": %lu,\n",
+		p->images, p->windows);
+	fprintf(file, "  \"weak_learners\": %lu,\n", p->weak_learners);
+	fprintf(file, "  \"weak_learners_per_window\": %g,\n",
+		p->windows ? (double)p->weak_learners / p->windows : 0.0);
+	fprintf(file, "  \"raw_detections\": %lu,\n  \"detections\": %lu,\n",
+		p->raw_det, p->det);
+	fprintf(file, "  \"time\": {\"intgraph\": %g, \"scan\": %g, "
+		"\"nms\": %g},\n", p->time[CAS_PROF_INTGRAPH],
+		p->time[CAS_PROF_SCAN], p->time[CAS_PROF_NMS]);
+
+	fprintf(file, "  \"scales\": [");
+	for (i = 0, n = 0; i < CAS_PROF_SCALES; ++i) {
+		if (p->scale_windows[i] == 0)
+			continue;
+		fprintf(file, "%s\n    {\"scale\": %d, \"len\": %d, "
+			"\"windows\": %lu}", (n++ > 0) ? "," : "", i,
+			p->scale_len[i], p->scale_windows[i]);
+	}
+	fprintf(file, "%s],\n", (n > 0) ? "\n  " : "");
+
+	fprintf(file, "  \"stages\": [");
+	for (n = CAS_PROF_STAGES; n > 0 && p->stage_in[n - 1] == 0; --n) ;
+	for (i = 0; i < n; ++i)
+		fprintf(file, "%s\n    {\"stage\": %d, \"in\": %lu, "
+			"\"pass\": %lu, \"pass_rate\": %g}", (i > 0) ? "," : "",
+			i, p->stage_in[i], p->stage_pass[i], p->stage_in[i] ?
+			(double)p->stage_pass[i] / p->stage_in[i] : 0.0);
+	fprintf(file, "%s]\n}\n", (n > 0) ? "\n  " : "");
+	return !ferror(file);
+}
+
+void cas_prof_window(num_t reached, num_t passed, unsigned long wl)
+{
+	ATOMIC_ADD(profile.windows, 1);
+	ATOMIC_ADD(profile.weak_learners, wl);
+	for (num_t i = 0; i < reached; ++i)
+		ATOMIC_ADD(profile.stage_in[STAGE(i)], 1);
+	for (num_t i = 0; i < passed; ++i)
+		ATOMIC_ADD(profile.stage_pass[STAGE(i)], 1);
+}
+
+void cas_prof_scale(num_t scale, imgsz_t len, unsigned long n)
+{
+	if (scale >= CAS_PROF_SCALES)
+		scale = CAS_PROF_SCALES - 1;
+	ATOMIC_STORE(profile.scale_len[scale], len);
+	ATOMIC_ADD(profile.scale_windows[scale], n);
+}
+
+void cas_prof_image(unsigned long raw_det, unsigned long det)
+{
+	ATOMIC_ADD(profile.images, 1);
+	ATOMIC_ADD(profile.raw_det, raw_det);
+	ATOMIC_ADD(profile.det, det);
+}
+
+double cas_prof_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void cas_prof_time(enum cas_prof_phase phase, double start)
+{
+	ATOMIC_ADD_FLT(profile.time[phase], cas_prof_now() - start);
+}
+
+#endif
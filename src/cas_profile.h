@@ -0,0 +1,113 @@
+#ifndef CAS_PROFILE_H
+#define CAS_PROFILE_H
+#include <stdbool.h>
+#include <stdio.h>
+#include "boost_cfg.h"
+/**
+ * \file cas_profile.h
+ * \brief 级联分类器检测过程的性能统计（函数声明）。
+ * 	仅在定义 CAS_PROFILE 宏时编译（如在 gcc 中加入编译选项 -DCAS_PROFILE），
+ * 	否则统计代码及本模块的接口均不存在，对检测速度没有任何影响。
+ * 	统计量为全局累计值，多线程检测时以原子操作累加
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-08-02
+ */
+#ifdef CAS_PROFILE
+
+/*******************************************************************************
+ * 				    宏定义
+ ******************************************************************************/
+/// 仅在开启性能统计时编译的语句
+#define CAS_PROF(...) __VA_ARGS__
+
+/// 最多统计的尺度数量，更大的尺度合并到最后一个尺度中统计
+#define CAS_PROF_SCALES 32
+/// 最多统计的级数，之后的各级合并到最后一级中统计
+#define CAS_PROF_STAGES 64
+
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 计时的检测阶段
+enum cas_prof_phase {
+	CAS_PROF_INTGRAPH,		///< 计算积分图（包括构建图像金字塔）
+	CAS_PROF_SCAN,			///< 扫描窗口
+	CAS_PROF_NMS,			///< 合并目标及极大值抑制
+	CAS_PROF_PHASES,		///< 阶段数量
+};
+
+/// 检测过程的统计信息（自上次重置以来的累计值）
+struct cas_profile {
+	unsigned long images;		///< 检测的图像数量
+	unsigned long windows;		///< 由分类器判别的窗口总数
+	unsigned long weak_learners;	///< 所计算的弱学习器总数（cas_h() 不统计
+					/**< 软级联的提前拒绝，按整级计数）*/
+	imgsz_t scale_len[CAS_PROF_SCALES];	///< 各尺度的窗口边长（原图像坐标）
+	unsigned long scale_windows[CAS_PROF_SCALES];	///< 各尺度扫描的窗口数
+	unsigned long stage_in[CAS_PROF_STAGES];	///< 进入各级的窗口数
+	unsigned long stage_pass[CAS_PROF_STAGES];	///< 通过各级的窗口数
+	unsigned long raw_det;		///< 极大值抑制前的目标数量
+	unsigned long det;		///< 极大值抑制后的目标数量
+	double time[CAS_PROF_PHASES];	///< 各阶段耗时（秒）
+};
+
+/*******************************************************************************
+ * 				    函数声明
+ ******************************************************************************/
+/**
+ * \brief 获取检测过程的统计信息
+ * \param[out] prof 用于保存统计信息
+ */
+void cas_profile_get(struct cas_profile *prof);
+
+/**
+ * \brief 重置检测过程的统计信息
+ */
+void cas_profile_reset(void);
+
+/**
+ * \brief 以 JSON 格式输出统计信息，包括各尺度的窗口数、各级的通过率、平均每个
+ * 	窗口计算的弱学习器数量及各阶段耗时
+ * \param[out] file 输出文件
+ * \return 成功则返回真，否则返回假
+ */
+bool cas_profile_dump(FILE * file);
+
+/**
+ * \brief 记录一个窗口的判别过程
+ * \param[in] reached 窗口进入的级数（最后一级为拒绝该窗口的级，或全部通过）
+ * \param[in] passed  窗口通过的级数
+ * \param[in] wl      所计算的弱学习器数量
+ */
+void cas_prof_window(num_t reached, num_t passed, unsigned long wl);
+
+/**
+ * \brief 记录某一尺度扫描的窗口数
+ * \param[in] scale 尺度编号（从 0 开始）
+ * \param[in] len   窗口边长（原图像坐标）
+ * \param[in] n     窗口数
+ */
+void cas_prof_scale(num_t scale, imgsz_t len, unsigned long n);
+
+/**
+ * \brief 记录一幅图像的检测结果
+ * \param[in] raw_det 极大值抑制前的目标数量
+ * \param[in] det     极大值抑制后的目标数量
+ */
+void cas_prof_image(unsigned long raw_det, unsigned long det);
+
+/// 返回当前时刻（秒），用于计时
+double cas_prof_now(void);
+
+/**
+ * \brief 累加某一阶段的耗时
+ * \param[in] phase 检测阶段
+ * \param[in] start 阶段开始时刻，由 cas_prof_now() 获取
+ */
+void cas_prof_time(enum cas_prof_phase phase, double start);
+
+#else
+#define CAS_PROF(...)
+#endif
+#endif
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "cas_queue.h"
+
+/**
+ * \file cas_queue.c
+ * \brief 有界的多生产者多消费者队列 -- 函数实现
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-08-02
+ */
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 有界队列：环形缓冲区
+struct cas_queue {
+	unsigned char *data;		///< 元素数组
+	size_t elem_size;		///< 单个元素的长度（字节）
+	size_t cap;			///< 队列容量
+	size_t head;			///< 队头元素的下标
+	size_t size;			///< 队列中的元素个数
+	bool closed;			///< 队列是否已关闭
+	pthread_mutex_t lock;		///< 保护以上成员的互斥锁
+	pthread_cond_t not_full;	///< 队列不满或已关闭
+	pthread_cond_t not_empty;	///< 队列不空或已关闭
+};
+
+/*******************************************************************************
+ * 				    函数定义
+ ******************************************************************************/
+struct cas_queue *cas_queue_new(size_t cap, size_t elem_size)
+{
+	if (cap == 0)
+		cap = 1;
+	struct cas_queue *q = malloc(sizeof(struct cas_queue));
+	if (q == NULL)
+		return NULL;
+	if ((q->data = malloc(elem_size * cap)) == NULL) {
+		free(q);
+		return NULL;
+	}
+	q->elem_size = elem_size;
+	q->cap = cap;
+	q->head = 0;
+	q->size = 0;
+	q->closed = false;
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->not_full, NULL);
+	pthread_cond_init(&q->not_empty, NULL);
+	return q;
+}
+
+bool cas_queue_push(struct cas_queue *q, const void *elem)
+{
+	pthread_mutex_lock(&q->lock);
+	while (q->size == q->cap && !q->closed)
+		pthread_cond_wait(&q->not_full, &q->lock);
+	if (q->closed) {
+		pthread_mutex_unlock(&q->lock);
+		return false;
+	}
+	size_t tail = (q->head + q->size) % q->cap;
+	memcpy(q->data + tail * q->elem_size, elem, q->elem_size);
+	++q->size;
+	pthread_cond_signal(&q->not_empty);
+	pthread_mutex_unlock(&q->lock);
+	return true;
+}
+
+bool cas_queue_pop(struct cas_queue *q, void *elem)
+{
+	pthread_mutex_lock(&q->lock);
+	while (q->size == 0 && !q->closed)
+		pthread_cond_wait(&q->not_empty, &q->lock);
+	if (q->size == 0) {
+		pthread_mutex_unlock(&q->lock);
+		return false;
+	}
+	memcpy(elem, q->data + q->head * q->elem_size, q->elem_size);
+	q->head = (q->head + 1) % q->cap;
+	--q->size;
+	pthread_cond_signal(&q->not_full);
+	pthread_mutex_unlock(&q->lock);
+	return true;
+}
+
+void cas_queue_close(struct cas_queue *q)
+{
+	pthread_mutex_lock(&q->lock);
+	q->closed = true;
+	pthread_cond_broadcast(&q->not_full);
+	pthread_cond_broadcast(&q->not_empty);
+	pthread_mutex_unlock(&q->lock);
+}
+
+void cas_queue_free(struct cas_queue *q)
+{
+	if (q == NULL)
+		return;
+	pthread_mutex_destroy(&q->lock);
+	pthread_cond_destroy(&q->not_full);
+	pthread_cond_destroy(&q->not_empty);
+	free(q->data);
+	free(q);
+}
@@ -0,0 +1,59 @@
+#ifndef CAS_QUEUE_H
+#define CAS_QUEUE_H
+#include <stddef.h>
+#include <stdbool.h>
+/**
+ * \file cas_queue.h
+ * \brief 有界的多生产者多消费者队列（元素定长，先进先出）-- 函数声明。
+ * 	队列满时生产者阻塞，队列空时消费者阻塞；关闭队列后不再接受新元素，消费
+ * 	者取完剩余元素后返回，用于级联分类器训练时并行挖掘难负样本
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-08-02
+ */
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 有界队列（不透明类型）
+struct cas_queue;
+
+/*******************************************************************************
+ * 				    函数声明
+ ******************************************************************************/
+/**
+ * \brief 创建队列
+ * \param[in] cap       队列容量（元素个数），为 0 时视为 1
+ * \param[in] elem_size 单个元素的长度（字节）
+ * \return 成功则返回队列，否则返回 NULL
+ */
+struct cas_queue *cas_queue_new(size_t cap, size_t elem_size);
+
+/**
+ * \brief 将元素复制到队尾，队列满时阻塞等待
+ * \param[in, out] q 队列
+ * \param[in] elem   要加入的元素
+ * \return 成功则返回真；队列已关闭时返回假，元素不加入队列
+ */
+bool cas_queue_push(struct cas_queue *q, const void *elem);
+
+/**
+ * \brief 从队头取出元素，队列空时阻塞等待
+ * \param[in, out] q 队列
+ * \param[out] elem  用于保存取出的元素
+ * \return 成功则返回真；队列已关闭且为空时返回假
+ */
+bool cas_queue_pop(struct cas_queue *q, void *elem);
+
+/**
+ * \brief 关闭队列，唤醒所有等待的线程（可重复调用）
+ * \param[in, out] q 队列
+ */
+void cas_queue_close(struct cas_queue *q);
+
+/**
+ * \brief 释放队列（不得有线程仍在使用该队列）
+ * \param[in] q cas_queue_new() 创建的队列，可以为 NULL
+ */
+void cas_queue_free(struct cas_queue *q);
+
+#endif
@@ -1,6 +1,9 @@
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "cas_sample.h"
+#include "cas_queue.h"
+#include "cas_store.h"
 /**
  * \file cas_sample.c
  * \brief Cascade 级联分类器的样本集类型函数实现
@@ -46,6 +49,80 @@ do {										\
 	v2 = tmp;								\
 } while(0);
 
+/// 并行挖掘时，每个检测线程对应的待检测图片数
+#define MINE_IMAGES 2
+/// 每张图片最多提供的负样本数，避免样本集被少数图片的假阳性窗口占据
+#define MINE_PER_IMAGE 32
+/// 并行挖掘时已取得但尚未存入样本集的图片数上限（每个检测线程另加正在检测的
+/// 一张），即挖掘结果缓冲区的数量
+#define MINE_SLOTS ((MINE_IMAGES + 1) * MINE_THREADS)
+
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 挖掘用的一张非人脸图片
+struct mine_image {
+	imgsz_t h;			///< 图片高度
+	imgsz_t w;			///< 图片宽度
+	num_t id;			///< 图片序号
+	unsigned char *img;		///< 图片的副本（回调函数可能复用其缓冲区）
+};
+
+/// 已获取但尚未挖掘的图片（链表结点）
+struct cas_carry {
+	struct mine_image im;		///< 图片
+	struct cas_carry *next;		///< 下一张图片
+};
+
+/// 并行挖掘时一张图片的挖掘结果
+struct mine_batch {
+	struct mine_image im;		///< 图片
+	num_t n;			///< 假阳性窗口数量
+	sample_t *win;			///< 假阳性窗口的积分图（每个窗口的两个
+					///< 积分图连续存放），最多
+					///< MINE_PER_IMAGE 个
+};
+
+/// 串行挖掘时接收窗口的参数：窗口直接存入样本集
+struct slot_sink {
+	struct cas_sample *sp;		///< 样本集
+	const num_t *slot;		///< 用于存放样本的槽位
+	num_t *filled;			///< 已存放的样本数量
+	num_t m;			///< 尚需的样本数量
+	imgsz_t img_size;		///< 样本尺寸
+	imgsz_t h;			///< 当前图片高度
+	imgsz_t w;			///< 当前图片宽度
+	const unsigned char *img;	///< 当前图片
+	num_t taken;			///< 当前图片已提供的样本数
+};
+
+/// 并行挖掘难负样本的共享状态
+struct miner {
+	struct cas_sample *sp;		///< 样本集（暂存的图片由生产者取用）
+	imgsz_t img_size;		///< 样本尺寸
+	void *args;			///< 用户自定义参数
+	cas_non_face_fn get_non_face;	///< 获取非人脸图片的回调函数
+	const struct cascade *cascade;	///< 已训练的级联分类器
+	const struct haar_ada_handles *hl;	///< Adaboost 分类器回调函数集
+	uint64_t key;			///< 派生各图片随机数状态的密钥
+	struct mine_batch batch[MINE_SLOTS];	///< 第 k 张图片的挖掘结果位于
+						///< batch[k % MINE_SLOTS]
+	num_t produced;			///< 已取得的图片数（仅生产者线程修改）
+	struct cas_queue *credit;	///< 生产许可，保证已取得但尚未存入样本
+					///< 集的图片不超过 MINE_SLOTS 张
+	struct cas_queue *images;	///< 待检测图片的编号
+	struct cas_queue *done;		///< 已检测图片的编号
+	unsigned int active;		///< 尚未结束的检测线程数（原子操作）
+	bool stop;			///< 样本是否已足够（原子操作）
+	bool failed;			///< 是否出错（原子操作）
+};
+
+/// 并行挖掘时接收窗口的参数：窗口采样为样本后存入挖掘结果
+struct batch_sink {
+	imgsz_t img_size;		///< 样本尺寸
+	struct mine_batch *b;		///< 当前图片的挖掘结果
+};
+
 /*******************************************************************************
  * 				  静态函数声明
  ******************************************************************************/
@@ -71,23 +148,36 @@ static void img_sampling(imgsz_t dst_size, sample_t dst[][dst_size],
  * \param[in] min_len 矩形框的最小边长
  * \param[in] height  矩形框所处图像的高度
  * \param[in] width   矩形框所处图像的宽度
+ * \param[in, out] ctx 训练上下文，为 NULL 时使用默认上下文
  */
 static void rand_rect(struct cas_rect *rect, imgsz_t min_len, imgsz_t height,
-		      imgsz_t width);
+		      imgsz_t width, struct train_ctx *ctx);
 
 /**
- * \brief 随机排列样本
+ * \brief 随机排列样本次序（不移动槽位中的样本）
  * \param[in, out] sp 已初始化的样本集
  * \param[in] num     样本数量
+ * \param[in, out] ctx 训练上下文，为 NULL 时使用默认上下文
  */
-static void shuffle(struct cas_sample *sp, num_t num);
+static void shuffle(struct cas_sample *sp, num_t num, struct train_ctx *ctx);
+
+/// 样本存放于文件时，提示即将按顺序访问第 i 个槽位
+static void stream(const struct cas_sample *sp, num_t i);
+
+/// 训练上下文的样本访问提示函数（train_stream_fn），store 为样本存储
+static void stream_slot(void *store, const void *x);
 
 /**
- * \brief 使用假阳性图片作为样本添加至样本集，直至达到指定样本数量
+ * \brief 使用假阳性图片作为样本添加至样本集，直至达到指定样本数量。
+ * 	各图片按随机次序扫描（见 cas_detector_mine()），不进行极大值抑制，样本
+ * 	足够或该图片已提供 MINE_PER_IMAGE 个样本时立即停止扫描。
+ * 	第 k 张图片的扫描次序由 train_ctx_derive(key, k) 决定；图片循环一遍时，
+ * 	再次取得的首张图片暂存于 sp，下次挖掘时使用
  * \param[out] sp          已初始化的样本集
- * \param[in, out] index   当前索引。从参数 sp 的第 *index 个样本开始存放样本，
- * 			   函数返回时 *index 置为未存放样本的索引（样本集末尾处）
+ * \param[in] slot         用于存放样本的槽位数组（长度为 m），样本依次存放于
+ * 			   sp 的第 slot[0]、slot[1]…… 个槽位
  * \param[in] m            最大样本数量
+ * \param[out] filled      用于保存已存放的样本数量
  * \param[in] img_size     用作训练的图片尺寸
  * \param[in, out] args    用户自定义的参数，用于保证可重入性
  * \param[in] get_non_face 回调函数，获取非人脸图片，参数 args 将被传递给该函数
@@ -95,18 +185,76 @@ static void shuffle(struct cas_sample *sp, num_t num);
  * \param[in] hl           指向 Adaboost 分类器回调函数集
  * \return 成功则返回真，否则返回假
  */
-static bool get_remain_samples(struct cas_sample *sp, num_t * index, num_t m,
-			       imgsz_t img_size, void *args,
-			       cas_non_face_fn get_non_face,
+static bool get_remain_samples(struct cas_sample *sp, const num_t slot[],
+			       num_t m, num_t * filled, imgsz_t img_size,
+			       void *args, cas_non_face_fn get_non_face,
 			       const struct cascade *cascade,
 			       const struct haar_ada_handles *hl);
 
+/**
+ * \brief 并行挖掘难负样本：生产者线程取得图片，MINE_THREADS 个检测线程并行
+ * 	检测，调用者线程按图片次序将各图片的假阳性窗口存入样本集，结果与串行
+ * 	挖掘相同。样本足够后，已取得但未用到的图片按原次序暂存于 sp
+ * \param[in] key 派生各图片随机数状态的密钥
+ * \details 其余参数及返回值同 get_remain_samples()
+ */
+static bool mine_samples(struct cas_sample *sp, const num_t slot[], num_t m,
+			 num_t * filled, imgsz_t img_size, void *args,
+			 cas_non_face_fn get_non_face,
+			 const struct cascade *cascade,
+			 const struct haar_ada_handles *hl, uint64_t key);
+
+/// 生产者线程：依次取得图片并交给检测线程，直至样本足够或图片循环一遍
+static void *mine_producer(void *miner);
+
+/// 检测线程：检测图片，将假阳性窗口采样为样本后存入该图片的挖掘结果
+static void *mine_worker(void *miner);
+
+/**
+ * \brief 取得下一张图片：优先取用样本集中暂存的图片，否则通过 get_non_face
+ * 	获取并复制
+ * \param[in, out] sp 样本集
+ * \param[out] im     用于保存图片，im->img 由调用者释放
+ * \return 成功则返回真，否则返回假
+ */
+static bool next_image(struct cas_sample *sp, struct mine_image *im,
+		       void *args, cas_non_face_fn get_non_face);
+
+/**
+ * \brief 将图片暂存于样本集，下次取得图片时最先取得
+ * \param[in, out] sp 样本集
+ * \param[in] im      图片，由样本集接管（失败时释放）
+ * \return 成功则返回真，否则返回假
+ */
+static bool carry_image(struct cas_sample *sp, const struct mine_image *im);
+
+/// 标记并行挖掘出错，并关闭所有队列
+static void mine_fail(struct miner *mn);
+
+/**
+ * \brief 保证检测器可容纳 h × w 的图片，否则按更大的尺寸重新创建检测器
+ * \param[in, out] det   检测器地址，*det 可以为 NULL；失败时置为 NULL
+ * \param[in, out] max_h 检测器的最大帧高度
+ * \param[in, out] max_w 检测器的最大帧宽度
+ * \return 成功则返回真，否则返回假
+ */
+static bool fit_detector(struct cas_detector **det, imgsz_t * max_h,
+			 imgsz_t * max_w, imgsz_t h, imgsz_t w,
+			 const struct cascade *cascade,
+			 const struct haar_ada_handles *hl);
+
+/// 挖掘扫描的回调函数（串行挖掘）：将窗口存入样本集
+static bool to_slot(const struct cas_rect *rect, void *sink);
+
+/// 挖掘扫描的回调函数（并行挖掘）：将窗口采样为样本并存入挖掘结果
+static bool to_batch(const struct cas_rect *rect, void *sink);
+
 /*******************************************************************************
  * 				    函数实现
  ******************************************************************************/
 bool init_samples(struct cas_sample *sp, imgsz_t img_size, num_t face,
 		  num_t non_face, void *args, cas_face_fn get_face,
-		  cas_non_face_fn get_non_face)
+		  cas_non_face_fn get_non_face, struct train_ctx *ctx)
 {
 	if (!alloc_sample(sp, face + non_face, img_size))
 		return false;
@@ -120,6 +268,7 @@ bool init_samples(struct cas_sample *sp, imgsz_t img_size, num_t face,
 	for (num_t i = 0; i < face; ++i) {
 		if ((x = get_face(&h, &w, &rect, args)) == NULL)
 			goto err;
+		stream(sp, index);
 		IMG_2_SP(sp, img_size, index, h, w, x, &rect, 1);
 		++index;
 	}
@@ -127,11 +276,14 @@ bool init_samples(struct cas_sample *sp, imgsz_t img_size, num_t face,
 	for (num_t i = 0; i < non_face; ++i) {
 		if ((x = get_non_face(&h, &w, &id, args)) == NULL)
 			goto err;
-		rand_rect(&rect, img_size, h, w);
+		rand_rect(&rect, img_size, h, w, ctx);
+		stream(sp, index);
 		IMG_2_SP(sp, img_size, index, h, w, x, &rect, -1);
 		++index;
 	}
-	shuffle(sp, face + non_face);
+	for (num_t i = 0; i < face + non_face; ++i)
+		sp->perm[i] = i;
+	shuffle(sp, face + non_face, ctx);
 
 	return true;
 err:
@@ -144,44 +296,173 @@ bool update_samples(struct cas_sample *sp, num_t * m, void *args,
 		    const struct cascade *cascade,
 		    const struct haar_ada_handles *hl)
 {
-	num_t i = 0;
-	num_t j = 0;
+	const struct haar_adaboost *stage = NULL;	// 最新一级
+	num_t kept = 0;		// 保留的样本数量
+	num_t top = *m;
+	num_t filled = 0;	// 新挖掘的样本数量
 	sample_t *tmp_x;
 	label_t tmp_y;
+	num_t tmp_n;
 
-	for (i = 0; i < *m; ++i)
-		if (sp->Y[i] > 0) {
-			SWAP(sp->X[j], sp->X[i], tmp_x);
-			SWAP(sp->X2[j], sp->X2[i], tmp_x);
-			SWAP(sp->Y[j], sp->Y[i], tmp_y);
-			++j;
-		}
+	for (link_iter iter = link_list_start_iter(&cascade->adaboost);
+	     link_list_check_end(iter); link_list_next_iter(&iter))
+		stage = link_list_get_data(iter);
+	// 借用 perm 记录槽位：保留的样本在前，被拒绝的负样本在后
+	for (num_t i = 0; i < *m; ++i) {
+		stream(sp, i);
+		if (sp->Y[i] > 0
+		    || hl->h(stage, img_size, img_size, img_size,
+			     (void *)sp->X[i], (void *)sp->X2[i], 1,
+			     &hl->wl_hl) >= 0)
+			sp->perm[kept++] = i;
+		else
+			sp->perm[--top] = i;
+	}
+	// 被拒绝的槽位按递增次序存放新样本
+	for (num_t i = kept, j = *m - 1; i < j; ++i, --j)
+		SWAP(sp->perm[i], sp->perm[j], tmp_n);
 	bool status =
-	    get_remain_samples(sp, &j, *m - j, img_size, args, get_non_face,
-			       cascade, hl);
-	num_t new_m = j;
+	    get_remain_samples(sp, sp->perm + kept, *m - kept, &filled,
+			       img_size, args, get_non_face, cascade, hl);
+	num_t new_m = kept + filled;
 	printf("new_m: %d\n", new_m);
-	for (; j < *m; ++j) {
-		free(sp->X[j]);
-		free(sp->X2[j]);
+	// 难负样本不足时，将未使用的槽位移至末尾并释放（样本存储保持不变）
+	if (new_m < *m) {
+		for (num_t i = new_m; i < *m; ++i)
+			sp->Y[sp->perm[i]] = 0;
+		for (num_t i = 0, j = *m; i < new_m; ++i) {
+			if (sp->Y[i] != 0)
+				continue;
+			while (sp->Y[--j] == 0) ;
+			SWAP(sp->X[i], sp->X[j], tmp_x);
+			SWAP(sp->X2[i], sp->X2[j], tmp_x);
+			SWAP(sp->Y[i], sp->Y[j], tmp_y);
+		}
+		for (num_t i = new_m; i < *m && sp->store == NULL; ++i) {
+			free(sp->X[i]);
+			free(sp->X2[i]);
+		}
 	}
 	*m = new_m;
-	shuffle(sp, new_m);
+	for (num_t i = 0; i < new_m; ++i)
+		sp->perm[i] = i;
+	shuffle(sp, new_m, hl->wl_hl.ctx);
 	return status;
 }
 
+bool write_samples(const struct cas_sample *sp, num_t m, imgsz_t img_size,
+		   FILE * file)
+{
+	unsigned char pixel[img_size][img_size];
+	if (fwrite(&m, sizeof(num_t), 1, file) < 1)
+		return false;
+	if (fwrite(sp->Y, sizeof(label_t), m, file) < (size_t) m
+	    || fwrite(sp->perm, sizeof(num_t), m, file) < (size_t) m)
+		return false;
+	// 样本由 8 位灰度图像计算而得，由积分图还原灰度值保存，读取时重新计算
+	for (num_t k = 0; k < m; ++k) {
+		const sample_t(*x)[img_size] = (const void *)sp->X[k];
+		stream(sp, k);
+		for (imgsz_t i = 0; i < img_size; ++i)
+			for (imgsz_t j = 0; j < img_size; ++j)
+				pixel[i][j] = x[i][j]
+				    - (i > 0 ? x[i - 1][j] : 0)
+				    - (j > 0 ? x[i][j - 1] : 0)
+				    + (i > 0 && j > 0 ? x[i - 1][j - 1] : 0);
+		if (fwrite(pixel, sizeof(pixel), 1, file) < 1)
+			return false;
+	}
+	return true;
+}
+
+bool read_samples(struct cas_sample *sp, num_t * m, imgsz_t img_size,
+		  FILE * file)
+{
+	unsigned char pixel[img_size][img_size];
+	if (fread(m, sizeof(num_t), 1, file) < 1 || *m <= 0)
+		return false;
+	if (!alloc_sample(sp, *m, img_size))
+		return false;
+	if (fread(sp->Y, sizeof(label_t), *m, file) < (size_t) *m
+	    || fread(sp->perm, sizeof(num_t), *m, file) < (size_t) *m)
+		goto err;
+	for (num_t k = 0; k < *m; ++k)
+		if (sp->perm[k] < 0 || sp->perm[k] >= *m)
+			goto err;
+	for (num_t k = 0; k < *m; ++k) {
+		sample_t(*x)[img_size] = (void *)sp->X[k];
+		if (fread(pixel, sizeof(pixel), 1, file) < 1)
+			goto err;
+		stream(sp, k);
+		for (imgsz_t i = 0; i < img_size; ++i)
+			for (imgsz_t j = 0; j < img_size; ++j)
+				x[i][j] = pixel[i][j];
+		memcpy(sp->X2[k], sp->X[k],
+		       sizeof(sample_t) * img_size * img_size);
+		intgraph(img_size, img_size, (void *)sp->X[k]);
+		intgraph2(img_size, img_size, (void *)sp->X2[k]);
+	}
+	return true;
+err:
+	free_samples(sp, *m);
+	return false;
+}
+
+void split_samples(struct cas_sample *sp, num_t num, num_t l)
+{
+	// 借用 PY 按槽位标记验证集样本
+	for (num_t i = 0; i < num; ++i)
+		sp->PY[i] = 0;
+	for (num_t i = 0; i < l; ++i)
+		sp->PY[sp->perm[i]] = 1;
+	for (num_t s = 0, i = 0, j = l; s < num; ++s)
+		sp->perm[sp->PY[s] ? i++ : j++] = s;
+	for (num_t i = 0; i < num; ++i) {
+		sp->PX[i] = sp->X[sp->perm[i]];
+		sp->PX2[i] = sp->X2[sp->perm[i]];
+		sp->PY[i] = sp->Y[sp->perm[i]];
+	}
+}
+
+void stream_samples(struct cas_sample *sp, struct train_ctx *ctx, bool on)
+{
+	if (sp->store == NULL)
+		return;
+	ctx = train_ctx_get(ctx);
+	ctx->stream = on ? stream_slot : NULL;
+	ctx->stream_arg = on ? sp->store : NULL;
+}
+
 void free_samples(struct cas_sample *sp, num_t count)
 {
-	for (num_t i = 0; i < count; ++i) {
+	struct mine_image im;
+	for (num_t i = 0; i < count && sp->store == NULL; ++i) {
 		free(sp->X[i]);
 		free(sp->X2[i]);
 	}
+	while (sp->carry != NULL && next_image(sp, &im, NULL, NULL))
+		free(im.img);
+	cas_store_free(sp->store);
 	free(sp->X);
 	free(sp->X2);
 	free(sp->Y);
+	free(sp->perm);
+	free(sp->PX);
+	free(sp->PX2);
+	free(sp->PY);
 }
 
 void intgraph(imgsz_t m, imgsz_t n, sample_t x[m][n])
+{
+	intgraph_ex(m, n, n, x);
+}
+
+void intgraph2(imgsz_t m, imgsz_t n, sample_t x[m][n])
+{
+	intgraph2_ex(m, n, n, x);
+}
+
+void intgraph_ex(imgsz_t m, imgsz_t n, imgsz_t wid, sample_t x[m][wid])
 {
 	imgsz_t i, j;
 	flt_t line_sum;
@@ -197,13 +478,13 @@ void intgraph(imgsz_t m, imgsz_t n, sample_t x[m][n])
 	}
 }
 
-void intgraph2(imgsz_t m, imgsz_t n, sample_t x[m][n])
+void intgraph2_ex(imgsz_t m, imgsz_t n, imgsz_t wid, sample_t x[m][wid])
 {
 	imgsz_t i, j;
 	for (i = 0; i < m; ++i)
 		for (j = 0; j < n; ++j)
 			x[i][j] *= x[i][j];
-	intgraph(m, n, x);
+	intgraph_ex(m, n, wid, x);
 }
 
 /*******************************************************************************
@@ -214,10 +495,29 @@ bool alloc_sample(struct cas_sample *sample, num_t m, imgsz_t img_size)
 	sample->X = malloc(sizeof(sample_t *) * m);
 	sample->X2 = malloc(sizeof(sample_t *) * m);
 	sample->Y = malloc(sizeof(label_t) * m);
-	if (!sample->X || !sample->X2 || !sample->Y)
+	sample->perm = malloc(sizeof(num_t) * m);
+	sample->PX = malloc(sizeof(sample_t *) * m);
+	sample->PX2 = malloc(sizeof(sample_t *) * m);
+	sample->PY = malloc(sizeof(label_t) * m);
+	if (!sample->X || !sample->X2 || !sample->Y || !sample->perm
+	    || !sample->PX || !sample->PX2 || !sample->PY)
 		goto malloc_err;
 	num_t n;
 	size_t len = sizeof(sample_t) * img_size * img_size;
+	sample->store = NULL;
+	sample->carry = NULL;
+#ifdef SAMPLE_STORE
+	// 同一样本的两个积分图相邻存放
+	sample->store = cas_store_new(SAMPLE_STORE, m, 2 * len,
+				      SAMPLE_STORE_BUDGET);
+	if (sample->store == NULL)
+		goto malloc_err;
+	for (n = 0; n < m; ++n) {
+		sample->X[n] = cas_store_get(sample->store, n);
+		sample->X2[n] = sample->X[n] + img_size * img_size;
+	}
+	return true;
+#endif
 	for (n = 0; n < m; ++n) {
 		if (!(sample->X[n] = (sample_t *) malloc(len)))
 			goto malloc_arrs_err;
@@ -237,6 +537,10 @@ malloc_err:
 	free(sample->X);
 	free(sample->X2);
 	free(sample->Y);
+	free(sample->perm);
+	free(sample->PX);
+	free(sample->PX2);
+	free(sample->PY);
 	return false;
 }
 
@@ -260,7 +564,7 @@ void img_sampling(imgsz_t dst_size, sample_t dst[][dst_size], imgsz_t src_size,
 }
 
 void rand_rect(struct cas_rect *rect, imgsz_t min_len, imgsz_t height,
-	       imgsz_t width)
+	       imgsz_t width, struct train_ctx *ctx)
 {
 	imgsz_t max_len = width;	// 矩形框的最大边长
 	if (height < max_len)
@@ -268,61 +572,318 @@ void rand_rect(struct cas_rect *rect, imgsz_t min_len, imgsz_t height,
 	if (max_len == min_len)
 		rect->len = min_len;
 	else
-		rect->len = rand() % (max_len - min_len) + min_len;
+		rect->len = train_rand(ctx) % (max_len - min_len) + min_len;
 	if (width == rect->len)
 		rect->start_x = 0;
 	else
-		rect->start_x = rand() % (width - rect->len);
+		rect->start_x = train_rand(ctx) % (width - rect->len);
 	if (height == rect->len)
 		rect->start_y = 0;
 	else
-		rect->start_y = rand() % (height - rect->len);
+		rect->start_y = train_rand(ctx) % (height - rect->len);
 }
 
-void shuffle(struct cas_sample *sp, num_t num)
+void shuffle(struct cas_sample *sp, num_t num, struct train_ctx *ctx)
 {
 	num_t index;
-	sample_t *tmp_x;
-	label_t tmp_y;
+	num_t tmp;
 	for (num_t i = num - 1; i > 0; --i) {
-		index = rand() % i;
-		SWAP(sp->X[i], sp->X[index], tmp_x);
-		SWAP(sp->X2[i], sp->X2[index], tmp_x);
-		SWAP(sp->Y[i], sp->Y[index], tmp_y);
+		index = train_rand(ctx) % i;
+		SWAP(sp->perm[i], sp->perm[index], tmp);
 	}
 }
 
-bool get_remain_samples(struct cas_sample *sp, num_t * index, num_t m,
-			imgsz_t img_size, void *args,
+void stream(const struct cas_sample *sp, num_t i)
+{
+	if (sp->store != NULL)
+		cas_store_stream(sp->store, i);
+}
+
+void stream_slot(void *store, const void *x)
+{
+	cas_store_stream(store, cas_store_slot(store, x));
+}
+
+bool get_remain_samples(struct cas_sample *sp, const num_t slot[], num_t m,
+			num_t * filled, imgsz_t img_size, void *args,
 			cas_non_face_fn get_non_face,
 			const struct cascade *cascade,
 			const struct haar_ada_handles *hl)
 {
-	imgsz_t h;
-	imgsz_t w;
-	num_t start_id;
-	num_t id;
-	link_iter iter;
-	struct link_list list;
-	const struct cas_det_rect * rect;
-	const unsigned char * img = get_non_face(&h, &w, &start_id, args);
-	do {
-		if (img == NULL)
-			return false;
-		list = cas_detect(cascade, h, w, (void *)img, DETECTOR_DELTA,
-				  hl);
-		//printf("list len: %d\n", list.size);
-		iter = link_list_start_iter(&list);
-		while (m > 0 && link_list_check_end(iter)) {
-			rect = link_list_get_data(iter);
-			IMG_2_SP(sp, img_size, *index, h, w, img, &rect->rect,
-				 -1);
-			++(*index);
-			link_list_next_iter(&iter);
-			--m;
+	struct slot_sink sink = { sp, slot, filled, m, img_size, 0, 0, NULL,
+		0
+	};
+	struct cas_detector *det = NULL;
+	imgsz_t max_h = 0, max_w = 0;
+	struct mine_image im;
+	struct train_ctx rng;
+	num_t start_id = 0;
+	uint64_t key;
+	bool status = true;
+	*filled = 0;
+	if (m <= 0)
+		return true;
+	// 每次挖掘只从训练上下文取一个随机数，各图片的扫描次序由其派生
+	key = train_next(hl->wl_hl.ctx);
+	// 多线程时由生产者线程获取图片，检测线程并行检测
+	if (MINE_THREADS > 1)
+		return mine_samples(sp, slot, m, filled, img_size, args,
+				    get_non_face, cascade, hl, key);
+	for (num_t k = 0; sink.m > 0; ++k) {
+		if (!next_image(sp, &im, args, get_non_face)) {
+			status = false;
+			break;
+		}
+		// 图片循环一遍后结束，该图片留待下次挖掘
+		if (k == 0) {
+			start_id = im.id;
+		} else if (im.id == start_id) {
+			status = carry_image(sp, &im);
+			break;
+		}
+		// 按随机次序扫描，样本足够时立即停止
+		train_ctx_derive(&rng, hl->wl_hl.ctx, key, k);
+		sink.h = im.h;
+		sink.w = im.w;
+		sink.img = im.img;
+		sink.taken = 0;
+		status = fit_detector(&det, &max_h, &max_w, im.h, im.w, cascade,
+				      hl)
+		    && cas_detector_mine(det, im.h, im.w, (const void *)im.img,
+					 &rng, to_slot, &sink);
+		free(im.img);
+		if (!status)
+			break;
+	}
+	cas_detector_free(det);
+	return status;
+}
+
+bool mine_samples(struct cas_sample *sp, const num_t slot[], num_t m,
+		  num_t * filled, imgsz_t img_size, void *args,
+		  cas_non_face_fn get_non_face,
+		  const struct cascade *cascade,
+		  const struct haar_ada_handles *hl, uint64_t key)
+{
+	struct miner mn = { sp, img_size, args, get_non_face, cascade, hl,
+		key
+	};
+	size_t area = (size_t) img_size * img_size;
+	sample_t *buf = malloc(sizeof(sample_t) * 2 * area * MINE_PER_IMAGE
+			       * MINE_SLOTS);
+	bool ready[MINE_SLOTS] = { false };
+	pthread_t producer, worker[MINE_THREADS];
+	unsigned int started = 0;
+	bool has_producer = false;
+	num_t next = 0, k;
+
+	mn.active = MINE_THREADS;
+	mn.credit = cas_queue_new(MINE_SLOTS, sizeof(num_t));
+	mn.images = cas_queue_new(MINE_SLOTS, sizeof(num_t));
+	mn.done = cas_queue_new(MINE_SLOTS, sizeof(num_t));
+	if (buf == NULL || mn.credit == NULL || mn.images == NULL
+	    || mn.done == NULL) {
+		mn.failed = true;
+		goto clean;
+	}
+	// 各队列容量均为 MINE_SLOTS，放入元素时不会阻塞
+	for (k = 0; k < MINE_SLOTS; ++k) {
+		mn.batch[k].win = buf + 2 * area * MINE_PER_IMAGE * k;
+		cas_queue_push(mn.credit, &k);
+	}
+
+	while (started < MINE_THREADS
+	       && pthread_create(&worker[started], NULL, mine_worker, &mn) == 0)
+		++started;
+	// 未能创建的检测线程视为已结束，最后结束的线程关闭结果队列
+	if (__atomic_sub_fetch(&mn.active, MINE_THREADS - started,
+			       __ATOMIC_ACQ_REL) == 0)
+		cas_queue_close(mn.done);
+	if (started == 0)
+		mine_fail(&mn);
+	else if (pthread_create(&producer, NULL, mine_producer, &mn) == 0)
+		has_producer = true;
+	else
+		mine_fail(&mn);
+
+	// 按图片次序存入样本：先完成的图片等待其前面的图片
+	while (*filled < m && cas_queue_pop(mn.done, &k)) {
+		ready[k % MINE_SLOTS] = true;
+		for (; *filled < m && ready[next % MINE_SLOTS]; ++next) {
+			struct mine_batch *b = &mn.batch[next % MINE_SLOTS];
+			for (num_t i = 0; i < b->n && *filled < m; ++i) {
+				const sample_t *win = b->win + 2 * area * i;
+				num_t s = slot[(*filled)++];
+				stream(sp, s);
+				memcpy(sp->X[s], win, sizeof(sample_t) * area);
+				memcpy(sp->X2[s], win + area,
+				       sizeof(sample_t) * area);
+				sp->Y[s] = -1;
+			}
+			free(b->im.img);
+			ready[next % MINE_SLOTS] = false;
+			cas_queue_push(mn.credit, &next);
 		}
-		link_list_free_full(&list, free);
-		img = get_non_face(&h, &w, &id, args);
-	} while(m > 0 && id != start_id);
+	}
+	// 样本已足够（或已无图片）：通知其他线程结束
+	__atomic_store_n(&mn.stop, true, __ATOMIC_RELEASE);
+	cas_queue_close(mn.credit);
+	if (has_producer)
+		pthread_join(producer, NULL);
+	for (unsigned int t = 0; t < started; ++t)
+		pthread_join(worker[t], NULL);
+	// 未存入的图片按原次序暂存，位于生产者线程暂存的图片之前
+	for (k = mn.produced - 1; k >= next; --k)
+		if (!carry_image(sp, &mn.batch[k % MINE_SLOTS].im))
+			mn.failed = true;
+
+clean:
+	cas_queue_free(mn.credit);
+	cas_queue_free(mn.images);
+	cas_queue_free(mn.done);
+	free(buf);
+	return !mn.failed;
+}
+
+void *mine_producer(void *miner)
+{
+	struct miner *mn = miner;
+	struct mine_image im;
+	num_t start_id = 0, k;
+
+	while (!__atomic_load_n(&mn->stop, __ATOMIC_ACQUIRE)
+	       && cas_queue_pop(mn->credit, &k)) {
+		if (!next_image(mn->sp, &im, mn->args, mn->get_non_face)) {
+			mine_fail(mn);
+			break;
+		}
+		// 与串行挖掘一致：图片循环一遍后结束，该图片留待下次挖掘
+		if (mn->produced == 0) {
+			start_id = im.id;
+		} else if (im.id == start_id) {
+			if (!carry_image(mn->sp, &im))
+				mine_fail(mn);
+			break;
+		}
+		k = mn->produced++;
+		mn->batch[k % MINE_SLOTS].im = im;
+		if (!cas_queue_push(mn->images, &k))
+			break;
+	}
+	cas_queue_close(mn->images);
+	return NULL;
+}
+
+void *mine_worker(void *miner)
+{
+	struct miner *mn = miner;
+	struct batch_sink sink = { mn->img_size, NULL };
+	struct cas_detector *det = NULL;
+	imgsz_t max_h = 0, max_w = 0;
+	struct train_ctx rng;
+	num_t k;
+	bool ok = true;
+
+	while (ok && cas_queue_pop(mn->images, &k)) {
+		sink.b = &mn->batch[k % MINE_SLOTS];
+		sink.b->n = 0;
+		// 样本已足够后不再检测，图片原样交回
+		if (!__atomic_load_n(&mn->stop, __ATOMIC_ACQUIRE)) {
+			train_ctx_derive(&rng, mn->hl->wl_hl.ctx, mn->key, k);
+			ok = fit_detector(&det, &max_h, &max_w, sink.b->im.h,
+					  sink.b->im.w, mn->cascade, mn->hl)
+			    && cas_detector_mine(det, sink.b->im.h,
+						 sink.b->im.w,
+						 (const void *)sink.b->im.img,
+						 &rng, to_batch, &sink);
+		}
+		ok = ok && cas_queue_push(mn->done, &k);
+	}
+	if (!ok)
+		mine_fail(mn);
+	if (__atomic_sub_fetch(&mn->active, 1, __ATOMIC_ACQ_REL) == 0)
+		cas_queue_close(mn->done);
+	cas_detector_free(det);
+	return NULL;
+}
+
+bool next_image(struct cas_sample *sp, struct mine_image *im, void *args,
+		cas_non_face_fn get_non_face)
+{
+	struct cas_carry *node = sp->carry;
+	const unsigned char *img;
+	if (node != NULL) {
+		*im = node->im;
+		sp->carry = node->next;
+		free(node);
+		return true;
+	}
+	if ((img = get_non_face(&im->h, &im->w, &im->id, args)) == NULL)
+		return false;
+	if ((im->img = malloc((size_t) im->h * im->w)) == NULL)
+		return false;
+	memcpy(im->img, img, (size_t) im->h * im->w);
 	return true;
 }
+
+bool carry_image(struct cas_sample *sp, const struct mine_image *im)
+{
+	struct cas_carry *node = malloc(sizeof(struct cas_carry));
+	if (node == NULL) {
+		free(im->img);
+		return false;
+	}
+	node->im = *im;
+	node->next = sp->carry;
+	sp->carry = node;
+	return true;
+}
+
+void mine_fail(struct miner *mn)
+{
+	__atomic_store_n(&mn->failed, true, __ATOMIC_RELEASE);
+	cas_queue_close(mn->credit);
+	cas_queue_close(mn->images);
+	cas_queue_close(mn->done);
+}
+
+bool fit_detector(struct cas_detector **det, imgsz_t * max_h, imgsz_t * max_w,
+		  imgsz_t h, imgsz_t w, const struct cascade *cascade,
+		  const struct haar_ada_handles *hl)
+{
+	struct cas_det_param param;
+	if (*det != NULL && h <= *max_h && w <= *max_w)
+		return true;
+	cas_detector_free(*det);
+	*max_h = (h > *max_h) ? h : *max_h;
+	*max_w = (w > *max_w) ? w : *max_w;
+	cas_det_param_default(&param);
+	param.delta = DETECTOR_DELTA;
+	*det = cas_detector_new(cascade, *max_h, *max_w, &param, hl);
+	return *det != NULL;
+}
+
+bool to_slot(const struct cas_rect *rect, void *sink)
+{
+	struct slot_sink *sk = sink;
+	stream(sk->sp, sk->slot[*sk->filled]);
+	IMG_2_SP(sk->sp, sk->img_size, sk->slot[*sk->filled], sk->h, sk->w,
+		 sk->img, rect, -1);
+	++(*sk->filled);
+	return --sk->m > 0 && ++sk->taken < MINE_PER_IMAGE;
+}
+
+bool to_batch(const struct cas_rect *rect, void *sink)
+{
+	struct batch_sink *sk = sink;
+	struct mine_batch *b = sk->b;
+	imgsz_t size = sk->img_size;
+	size_t area = (size_t) size * size;
+	sample_t *win = b->win + 2 * area * b->n;
+	img_sampling(size, (void *)win, b->im.w, (const void *)b->im.img,
+		     rect);
+	memcpy(win + area, win, sizeof(sample_t) * area);
+	intgraph(size, size, (void *)win);
+	intgraph2(size, size, (void *)(win + area));
+	return ++b->n < MINE_PER_IMAGE;
+}
@@ -14,11 +14,23 @@
 /*******************************************************************************
  * 				    类型定义
  ******************************************************************************/
-/// 级联分类器的样本集类型
+/// 挖掘难负样本时暂存的图片（不透明类型）
+struct cas_carry;
+
+/// 级联分类器的样本集类型。样本存放于固定的槽位中，更新样本集时被拒绝的负
+/// 样本槽位直接用于存放新样本；训练集与验证集的划分由样本次序 perm 决定。
+/// 定义 SAMPLE_STORE 时，各槽位位于映射到文件的样本存储中（见 cas_store.h）
 struct cas_sample {
-	sample_t **X;		///< 积分图指针数组
-	sample_t **X2;		///< （灰度值平方的）积分图指针数组
-	label_t *Y;		///< 样本标签数组
+	sample_t **X;		///< 积分图指针数组（按槽位）
+	sample_t **X2;		///< （灰度值平方的）积分图指针数组（按槽位）
+	label_t *Y;		///< 样本标签数组（按槽位）
+	num_t *perm;		///< 样本次序（槽位下标），验证集在前、训练集在后
+	const sample_t **PX;	///< 按样本次序排列的积分图指针数组
+	const sample_t **PX2;	///< 按样本次序排列的（灰度值平方的）积分图指针数组
+	label_t *PY;		///< 按样本次序排列的样本标签数组
+	struct cas_store *store;	///< 样本存储，为 NULL 时样本位于堆内存
+	struct cas_carry *carry;	///< 已获取但尚未挖掘的非人脸图片
+					///< （链表），下次挖掘时优先使用
 };
 
 /*******************************************************************************
@@ -33,17 +45,24 @@ struct cas_sample {
  * \param[in, out] args    用户自定义参数
  * \param[in] get_face     回调函数，用于获取人脸样本，args 将被传递给该函数
  * \param[in] get_non_face 回调函数，用于获取非人脸图片，args 将被传递给该函数
+ * \param[in, out] ctx    训练上下文（随机截取非人脸区域、打乱样本次序），
+ * 	为 NULL 时使用默认上下文
  * \return 成功则返回真，否则返回假
  */
 bool init_samples(struct cas_sample *sp, imgsz_t img_size, num_t face,
 		  num_t non_face, void *args, cas_face_fn get_face,
-		  cas_non_face_fn get_non_face);
+		  cas_non_face_fn get_non_face, struct train_ctx *ctx);
 
 /**
-* \brief 更新调整训练集和验证集
+* \brief 更新调整训练集和验证集。正样本保持不变；负样本均已通过此前各级，只需
+* 	用最新一级判断，仍被接受的负样本予以保留，被拒绝的负样本的槽位（内存不释放）
+* 	用于存放新挖掘的难负样本，最后重新产生样本次序。
+* 	每次挖掘只从训练上下文取一个随机数，各图片的扫描次序由其按图片次序派生，
+* 	样本按图片次序存入，因此结果与检测线程数（MINE_THREADS）无关；已获取但
+* 	未用到的图片暂存于 sp，下次挖掘时优先使用
 * \param[in, out] sp      已初始化的样本集地址（包括训练集和验证集）
 * \param[in, out] m       指向样本集样本数量。函数运行后，样本集样本数量数量将会
-* 			  减少，不被使用的样本将被释放
+* 			  减少（无足够的难负样本时），不被使用的样本将被释放
 * \param[in, out] args    用户自定义参数
 * \param[in] img_size     训练样本的尺寸
 * \param[in] get_non_face 回调函数，用于获取非人脸图片，args 将被传递给该函数
@@ -55,6 +74,50 @@ bool update_samples(struct cas_sample *sp, num_t * m, void *args,
 		    const struct cascade *cascade,
 		    const struct haar_ada_handles *hl);
 
+/**
+ * \brief 按样本次序划分验证集（前 l 个）与训练集，验证集在前、训练集在后
+ * 	（与 haar_ada_train_fn 的样本排列一致），两部分各自按槽位递增排列，
+ * 	使训练时对样本的扫描按存储地址顺序进行；结果写入 PX、PX2、PY
+ * \param[in, out] sp 已初始化的样本集
+ * \param[in] num     样本数量
+ * \param[in] l       验证集样本数量
+ */
+void split_samples(struct cas_sample *sp, num_t num, num_t l);
+
+/**
+ * \brief 开启或关闭训练时的样本访问提示。样本位于样本存储时，开启后 Adaboost
+ * 	训练对 PX、PX2 的每次顺序扫描都经 ctx 的样本访问提示（见 train_stream()）
+ * 	按槽位分块换入换出，常驻内存受 SAMPLE_STORE_BUDGET 限制；样本位于堆内存
+ * 	时不做任何事。开启期间 ctx 不应同时用于其他训练
+ * \param[in] sp      已初始化的样本集
+ * \param[in, out] ctx 训练上下文，为 NULL 时使用默认上下文
+ * \param[in] on      为真时开启，为假时关闭
+ */
+void stream_samples(struct cas_sample *sp, struct train_ctx *ctx, bool on);
+
+/**
+ * \brief 写入样本集到文件（用于训练检查点）。仅保存样本的灰度图像（样本均由 8
+ * 	位灰度图像计算而得），读取时重新计算积分图；槽位及样本次序保持不变
+ * \param[in] sp       已初始化的样本集
+ * \param[in] m        样本数量
+ * \param[in] img_size 样本尺寸
+ * \param[out] file    已打开文件的文件指针（可写，二进制形式）
+ * \return 成功则返回真，否则返回假
+ */
+bool write_samples(const struct cas_sample *sp, num_t m, imgsz_t img_size,
+		   FILE * file);
+
+/**
+ * \brief 从文件读取 write_samples() 写入的样本集
+ * \param[out] sp      未初始化的样本集
+ * \param[out] m       用于保存样本数量
+ * \param[in] img_size 样本尺寸
+ * \param[in] file     已打开文件的文件指针（可读，二进制形式）
+ * \return 成功则返回真，否则返回假（此时不占用内存）
+ */
+bool read_samples(struct cas_sample *sp, num_t * m, imgsz_t img_size,
+		  FILE * file);
+
 /**
  * \brief 释放样本集内存
  * \param[in] sp -已初始化的样本集地址
@@ -76,4 +139,19 @@ void intgraph(imgsz_t m, imgsz_t n, sample_t x[m][n]);
  */
 void intgraph2(imgsz_t m, imgsz_t n, sample_t x[m][n]);
 
+/**
+ * \brief 计算矩阵左上角 m×n 区域的积分图（结果与 intgraph() 相同）
+ * \param[in] m     区域高度
+ * \param[in] n     区域宽度
+ * \param[in] wid   矩阵的实际宽度（不小于 n）
+ * \param[in, out] x 保存有灰度图像的矩阵，积分图也将保存在此
+ */
+void intgraph_ex(imgsz_t m, imgsz_t n, imgsz_t wid, sample_t x[m][wid]);
+
+/**
+ * \brief 计算矩阵左上角 m×n 区域的积分图（对灰度值的平方累加）
+ * \details \copydetails intgraph_ex
+ */
+void intgraph2_ex(imgsz_t m, imgsz_t n, imgsz_t wid, sample_t x[m][wid]);
+
 #endif
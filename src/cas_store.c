@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "cas_store.h"
+
+/**
+ * \file cas_store.c
+ * \brief 基于文件映射（mmap）的样本存储 -- 函数实现
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-08-04
+ */
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 样本存储：映射到临时文件的连续槽位
+struct cas_store {
+	unsigned char *base;		///< 映射区域起始地址
+	size_t len;			///< 映射区域长度（字节）
+	size_t slot_size;		///< 单个槽位的长度（字节）
+	size_t budget;			///< 常驻内存预算（字节，按页对齐），0 为不限制
+	size_t mark;			///< 本轮顺序访问中仍驻留部分的起始位置（字节）
+	size_t last;			///< 上一次访问的位置（字节）
+};
+
+/*******************************************************************************
+ * 				    函数定义
+ ******************************************************************************/
+struct cas_store *cas_store_new(const char *prefix, size_t n, size_t slot_size,
+				size_t budget)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	char path[strlen(prefix) + sizeof("XXXXXX")];
+	struct cas_store *st = malloc(sizeof(struct cas_store));
+	if (st == NULL)
+		return NULL;
+	st->len = (n * slot_size + page - 1) / page * page;
+	st->slot_size = slot_size;
+	st->budget = (budget + page - 1) / page * page;
+	st->mark = 0;
+	st->last = 0;
+
+	// 文件名删除后，文件随映射区域解除而释放
+	sprintf(path, "%sXXXXXX", prefix);
+	int fd = mkstemp(path);
+	if (fd < 0)
+		goto file_err;
+	unlink(path);
+	if (ftruncate(fd, st->len) != 0)
+		goto map_err;
+	st->base = mmap(NULL, st->len, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+			0);
+	if (st->base == MAP_FAILED)
+		goto map_err;
+	close(fd);
+	// 训练时按槽位顺序扫描样本：预读其后的页，尽早回收已访问的页
+	madvise(st->base, st->len, MADV_SEQUENTIAL);
+	return st;
+
+map_err:
+	close(fd);
+file_err:
+	free(st);
+	return NULL;
+}
+
+void *cas_store_get(const struct cas_store *st, size_t i)
+{
+	return st->base + i * st->slot_size;
+}
+
+size_t cas_store_slot(const struct cas_store *st, const void *p)
+{
+	return ((const unsigned char *)p - st->base) / st->slot_size;
+}
+
+void cas_store_stream(struct cas_store *st, size_t i)
+{
+	size_t pos = i * st->slot_size;
+	if (st->budget == 0)
+		return;
+	if (pos < st->last)
+		st->mark = 0;		// 开始新一轮顺序访问
+	st->last = pos;
+	if (pos < st->mark + 2 * st->budget)
+		return;
+	// 保留最近访问的 budget 字节，其前面的部分写回文件并解除驻留
+	size_t end = (pos - st->budget) / st->budget * st->budget;
+	msync(st->base + st->mark, end - st->mark, MS_SYNC);
+	madvise(st->base + st->mark, end - st->mark, MADV_DONTNEED);
+	st->mark = end;
+}
+
+void cas_store_free(struct cas_store *st)
+{
+	if (st == NULL)
+		return;
+	munmap(st->base, st->len);
+	free(st);
+}
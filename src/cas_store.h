@@ -0,0 +1,67 @@
+#ifndef CAS_STORE_H
+#define CAS_STORE_H
+#include <stddef.h>
+#include <stdbool.h>
+/**
+ * \file cas_store.h
+ * \brief 基于文件映射（mmap）的样本存储 -- 函数声明。
+ * 	存储区由 n 个定长槽位组成，存放于临时文件中（创建后即删除文件名），
+ * 	由操作系统按需换入换出，使样本集可大于物理内存。按槽位顺序访问时，
+ * 	每访问 budget 字节即将其前面的部分写回文件并解除驻留，常驻内存不超过
+ * 	约 2 × budget 字节
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-08-04
+ */
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 样本存储（不透明类型）
+struct cas_store;
+
+/*******************************************************************************
+ * 				    函数声明
+ ******************************************************************************/
+/**
+ * \brief 创建样本存储
+ * \param[in] prefix    临时文件名前缀（可包含目录），文件名为 prefix 后接 6 个
+ * 	随机字符
+ * \param[in] n         槽位数量
+ * \param[in] slot_size 单个槽位的长度（字节）
+ * \param[in] budget    顺序访问时的常驻内存预算（字节），为 0 时不限制
+ * \return 成功则返回样本存储，否则返回 NULL
+ */
+struct cas_store *cas_store_new(const char *prefix, size_t n, size_t slot_size,
+				size_t budget);
+
+/**
+ * \brief 获取槽位地址
+ * \param[in] st 样本存储
+ * \param[in] i  槽位下标（小于槽位数量）
+ * \return 返回第 i 个槽位的地址
+ */
+void *cas_store_get(const struct cas_store *st, size_t i);
+
+/**
+ * \brief 获取地址所在的槽位
+ * \param[in] st 样本存储
+ * \param[in] p  槽位内的地址（如 cas_store_get() 的返回值）
+ * \return 返回 p 所在槽位的下标
+ */
+size_t cas_store_slot(const struct cas_store *st, const void *p);
+
+/**
+ * \brief 顺序访问提示：即将访问第 i 个槽位。按槽位下标递增访问时，超出预算的
+ * 	已访问部分被写回文件并解除驻留；下标回退时视为开始新一轮顺序访问
+ * \param[in, out] st 样本存储
+ * \param[in] i       槽位下标（小于槽位数量）
+ */
+void cas_store_stream(struct cas_store *st, size_t i);
+
+/**
+ * \brief 释放样本存储（临时文件随之删除）
+ * \param[in] st cas_store_new() 创建的样本存储，可以为 NULL
+ */
+void cas_store_free(struct cas_store *st);
+
+#endif
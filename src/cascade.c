@@ -1,8 +1,12 @@
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include <float.h>
 #include "cascade.h"
 #include "cas_sample.h"
+#include "cas_pool.h"
+#include "cas_profile.h"
+#include "pack_array.h"
 /**
  * \file cascade.c
  * \brief 级联的(Cascade) adaboost 分类器函数定义
@@ -30,6 +34,125 @@
 	(_x < _y) ? _x : _y;							\
 })
 
+/**
+ * \brief 保证数组 buf 可容纳 n 个元素，不足时扩容（至少为原容量的两倍）
+ * \param buf 由 malloc() 申请的数组（可以为 NULL），扩容后被更新
+ * \param cap 数组容量（size_t 型左值），扩容后被更新
+ * \param n   所需容量
+ * \return 成功则返回真；无法申请内存时返回假，此时 buf、cap 不变
+ */
+#define RESERVE(buf, cap, n)							\
+({										\
+	size_t _n = (n);							\
+	bool _ok = true;							\
+	if (_n > (cap)) {							\
+		size_t _cap = MAX(_n, 2 * (cap));				\
+		typeof(buf) _p = realloc((buf), sizeof(*(buf)) * _cap);		\
+		if ((_ok = (_p != NULL))) {					\
+			(buf) = _p;						\
+			(cap) = _cap;						\
+		}								\
+	}									\
+	_ok;									\
+})
+
+/**
+ * \brief 遍历矩形所覆盖的所有网格，用于极大值抑制的网格索引
+ * \param[in] r    矩形（struct cas_rect *）
+ * \param[in] cell 网格边长
+ * \param[in] cols 每行网格数
+ * \param c        循环变量名，依次为所覆盖网格的编号（行优先）
+ */
+#define GRID_FOR_EACH(r, cell, cols, c)						\
+	for (imgsz_t _gi = (r)->start_y / (cell);				\
+	     _gi <= ((r)->start_y + (r)->len - 1) / (cell); ++_gi)		\
+		for (imgsz_t _gj = (r)->start_x / (cell);			\
+		     _gj <= ((r)->start_x + (r)->len - 1) / (cell); ++_gj)	\
+			for (size_t c = (size_t) _gi * (cols) + _gj, _go = 1;	\
+			     _go; _go = 0)
+
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 扫描的一个尺度
+struct scan_scale {
+	imgsz_t len;			///< 窗口边长（原图像坐标）
+	flt_t rate;			///< 原图像与所扫描图像的尺寸之比
+	imgsz_t h;			///< 当前帧在该尺度下所扫描图像的高度
+	imgsz_t w;			///< 当前帧在该尺度下所扫描图像的宽度
+	imgsz_t stride;			///< 积分图的实际宽度（按最大帧计算）
+	flt_t *x;			///< 所扫描图像的积分图
+	flt_t *x2;			///< 所扫描图像灰度值平方的积分图
+	flt_t *buf;			///< 图像金字塔中该层的积分图（由该结构体
+					/**< 持有），为 NULL 时扫描原图像 */
+	imgsz_t win;			///< 所扫描图像上的窗口边长
+	imgsz_t delta;			///< 所扫描图像上窗口每次移动的像素数
+	imgsz_t skip;			///< 首行跳过的像素数（与 cas_nextobj() 一致）
+	bool used;			///< 当前帧是否有该尺度的任务
+	bool compiled;			///< 是否已编译，否则逐窗口调用 cas_h()
+	struct cas_compiled cc;		///< 该尺度下编译后的级联分类器
+};
+
+/// 扫描的一行窗口（一个检测任务）
+struct scan_row {
+	num_t scale;			///< 所在尺度
+	imgsz_t y;			///< 窗口左上角纵坐标
+	imgsz_t x0;			///< 第一个窗口左上角的横坐标
+	imgsz_t x1;			///< 最后一个窗口左上角横坐标的上限
+};
+
+/// 检测器
+struct cas_detector {
+	const struct cascade *cascade;	///< 级联分类器
+	const struct haar_ada_handles *hl;	///< Adaboost 相关回调函数集合
+	struct cas_det_param param;	///< 检测参数
+	imgsz_t max_h;			///< 最大帧高度
+	imgsz_t max_w;			///< 最大帧宽度（积分图的实际宽度）
+	imgsz_t h;			///< 当前帧高度
+	imgsz_t w;			///< 当前帧宽度
+	const unsigned char *img;	///< 当前帧
+	flt_t *x;			///< 积分图（max_h × max_w）
+	flt_t *x2;			///< 灰度值平方的积分图
+	num_t scale_ct;			///< 当前帧的尺度数量
+	num_t scale_cap;		///< 最大帧的尺度数量
+	struct scan_scale *scales;	///< 各尺度
+	size_t row_ct;			///< 当前帧的任务数量
+	size_t row_cap;			///< 任务数组的容量
+	struct scan_row *rows;		///< 各任务，按扫描顺序排列
+	struct cas_pool *pool;		///< 常驻线程池
+	unsigned int threads;		///< 线程池的实际线程数量
+	struct pack_array *found;	///< 各线程私有的目标缓冲区
+	bool *failed;			///< 各线程是否申请内存失败
+	struct cas_scan_stat *stat;	///< 各线程私有的扫描统计信息
+	struct cas_det_array det;	///< 合并后的目标
+	size_t det_cap;			///< det 的容量
+	bool *removed;			///< 极大值抑制：各目标是否被抑制
+	size_t removed_cap;		///< removed 的容量
+	size_t *start;			///< 极大值抑制：各网格的目标在 item 中的起点
+	size_t start_cap;		///< start 的容量
+	size_t *item;			///< 极大值抑制：按网格排列的目标下标
+	size_t item_cap;		///< item 的容量
+};
+
+/// 训练检查点中保存的训练参数，恢复时须与调用参数一致
+struct ckpt_param {
+	flt_t d;			///< 单个 Adaboost 分类器的最小检测率
+	flt_t f;			///< 单个 Adaboost 分类器的最大假阳率
+	flt_t F;			///< 级联分类器的最大假阳率
+	flt_t train_pct;		///< 训练集在样本中的占比
+	num_t face;			///< 人脸样本数量
+	num_t non_face;			///< 非人脸样本数量
+	imgsz_t img_size;		///< 训练图片尺寸
+};
+
+/// 批量检测的参数（线程池回调函数的参数）
+struct batch_args {
+	struct cas_detector **det;	///< 各线程的检测器
+	const struct cas_batch_image *imgs;	///< 各图像
+	struct cas_det_array *res;	///< 各图像的检测结果
+	bool *failed;			///< 各线程是否检测失败
+};
+
 /*******************************************************************************
  * 				  静态函数声明
  ******************************************************************************/
@@ -40,8 +163,140 @@ static void *ada_read(va_list ap, FILE * file);
 /// Adaboost 内存释放方法的包装函数，用作链表的回调函数
 static void ada_free(void *adaboost, va_list ap);
 
-/// 使用极大值抑制方法处理重叠边框
-static void NMS(struct link_list *list, flt_t threshold);
+/**
+ * \brief 级联分类器训练的实现
+ * \param[in] ckpt 检查点文件路径，为 NULL 时不使用检查点
+ * \details 其余参数同 cas_train()
+ */
+static bool train(struct cascade *cascade, const char *ckpt, flt_t d, flt_t f,
+		  flt_t F, flt_t train_pct, num_t face, num_t non_face,
+		  imgsz_t img_size, void *args, cas_face_fn get_face,
+		  cas_non_face_fn get_non_face, struct haar_ada_handles *hl);
+
+/**
+ * \brief 写入训练检查点：将训练参数、训练上下文（为 NULL 时为默认上下文）的
+ * 	随机数状态、级联分类器、样本集写入临时文件，最后重命名为 path
+ * \return 成功则返回真，否则返回假
+ */
+static bool save_ckpt(const char *path, const struct ckpt_param *cp,
+		      const struct cascade *cascade,
+		      const struct cas_sample *sp, num_t sp_len,
+		      const struct haar_ada_handles *hl);
+
+/**
+ * \brief 读取训练检查点，并恢复训练上下文（为 NULL 时为默认上下文）的随机数
+ * 	状态
+ * \param[out] found 检查点文件是否存在；不存在时返回真，其余输出参数不变
+ * \return 成功或文件不存在时返回真；文件损坏或训练参数不一致时返回假
+ */
+static bool load_ckpt(const char *path, const struct ckpt_param *cp,
+		      struct cascade *cascade, struct cas_sample *sp,
+		      num_t *sp_len, const struct haar_ada_handles *hl,
+		      bool *found);
+
+/// 从训练检查点读取一个 type 类型的参数，并判断其与调用参数 val 是否一致
+#define CKPT_SAME(file, type, val)						\
+({										\
+	type _v;								\
+	fread(&_v, sizeof(_v), 1, (file)) == 1 && _v == (val);			\
+})
+
+/**
+ * \brief 使用极大值抑制方法处理重叠边框（使用检测器的缓冲区）
+ * \param[in, out] det  检测器，det->det 按置信度从大到小排列（置信度相同时按
+ * 	扫描顺序）；函数执行后仅保留未被抑制的目标
+ * \param[in] threshold 重叠度阈值，重叠度大于该值的目标将被抑制
+ * \return 成功则返回真；无法申请内存时返回假，此时 det->det 不变
+ */
+static bool NMS(struct cas_detector *det, flt_t threshold);
+
+/**
+ * \brief 级联分类器对单个窗口的输出（同 cas_h()）
+ * \param[out] passed 窗口通过的强学习器数量
+ * \details 其余参数同 cas_h()
+ */
+static flt_t cascade_h(const struct cascade *cascade, imgsz_t n, imgsz_t wid,
+		       const flt_t x[n][wid], const flt_t x2[n][wid],
+		       const struct haar_ada_handles *hl, num_t *passed);
+
+/**
+ * \brief 编译后的级联分类器对单个窗口的输出（同 cas_compiled_h()）
+ * \param[out] passed 窗口通过的强学习器数量
+ * \details 其余参数同 cas_compiled_h()
+ */
+static flt_t compiled_h(const struct cas_compiled *cc, const flt_t * x,
+			const flt_t * x2, num_t *passed);
+
+/**
+ * \brief 设置一个尺度：放大特征时扫描原图像；否则申请图像金字塔中该层（按最
+ * 	大帧计算）的缓冲区。并编译该尺度下的级联分类器
+ * \param[out] sc   要设置的尺度
+ * \param[in] det   已设置级联分类器及最大帧尺寸的检测器
+ * \param[in] len   窗口边长（原图像坐标）
+ * \param[in] delta 窗口每次移动的像素数（原图像坐标）
+ * \return 成功则返回真，否则返回假
+ */
+static bool init_scale(struct scan_scale *sc, const struct cas_detector *det,
+		       imgsz_t len, imgsz_t delta);
+
+/// 设置检测器的当前帧并计算其积分图，设置当前帧的尺度；帧过大时返回假
+static bool load_frame(struct cas_detector *det, imgsz_t h, imgsz_t w,
+		       const unsigned char img[h][w]);
+
+/// 按检测器的当前帧设置一个尺度所扫描图像的尺寸
+static void frame_scale(struct scan_scale *sc, const struct cas_detector *det);
+
+/// 按最近邻采样（同 img_sampling()）缩小当前帧，并计算图像金字塔中该层的积分图
+static void build_level(struct scan_scale *sc, const struct cas_detector *det);
+
+/// 将当前帧各尺度的每一行窗口划分为一个任务，成功则返回真
+static bool full_rows(struct cas_detector *det);
+
+/**
+ * \brief 仅在给定区域附近划分任务：各区域向四周扩展，在区域边长上下若干尺度
+ * 	中，取完全位于扩展后范围内、且位于全图扫描网格上的窗口
+ * \param[in, out] det 已设置当前帧的检测器
+ * \param[in] roi      要扫描的区域
+ * \param[in] roi_ct   区域数量
+ * \return 成功则返回真，否则返回假
+ */
+static bool roi_rows(struct cas_detector *det, const struct cas_det_rect roi[],
+		     size_t roi_ct);
+
+/// 追加一个任务，成功则返回真
+static bool push_row(struct cas_detector *det, num_t scale, imgsz_t y,
+		     imgsz_t x0, imgsz_t x1);
+
+/// 线程池的回调函数，检测一行窗口（自适应扫描时调整步长、重新扫描邻域）
+static void scan_row(size_t task, unsigned int worker, void *args);
+
+/**
+ * \brief 检测所扫描图像上的一个窗口，目标保存到线程私有的缓冲区
+ * \param[in, out] det 检测器
+ * \param[in] sc       窗口所在尺度
+ * \param[in] i        窗口左上角纵坐标（所扫描图像坐标）
+ * \param[in] j        窗口左上角横坐标
+ * \param[in] worker   线程编号
+ * \param[out] result  级联分类器的输出
+ * \param[out] passed  窗口通过的强学习器数量
+ * \return 成功则返回真；无法申请内存时返回假，并设置 det->failed[worker]
+ */
+static bool scan_window(struct cas_detector *det, const struct scan_scale *sc,
+			imgsz_t i, imgsz_t j, unsigned int worker,
+			flt_t *result, num_t *passed);
+
+/// 线程池的回调函数，使用线程私有的检测器检测一幅图像，并复制其结果
+static void batch_image(size_t task, unsigned int worker, void *args);
+
+/// 按扫描顺序（尺度、纵坐标、横坐标）比较两个目标
+static int det_cmp(const void *a, const void *b);
+
+/// 按置信度从大到小比较两个目标，置信度相同时按扫描顺序，用于 qsort()
+static int conf_cmp(const void *a, const void *b);
+
+/// 将各线程的目标合并到 det->det，并按置信度从大到小排列；成功则返回真
+static bool merge(struct cas_detector *det);
+
 
 /*******************************************************************************
  * 				    函数实现
@@ -51,75 +306,18 @@ bool cas_train(struct cascade *cascade, flt_t d, flt_t f, flt_t F,
 	       void *args, cas_face_fn get_face, cas_non_face_fn get_non_face,
 	       struct haar_ada_handles *hl)
 {
-	struct haar_adaboost *adaboost = NULL;	// Adaboost 地址
-	flt_t ada_f_p_ratio;	// AdaBoost 假阳率
-	flt_t ada_det_ratio;	// AdaBoost 检测率
-
-	cascade->img_size = img_size;	// 设置图像尺寸
-	cascade->f_p_ratio = 1;	// 当前假阳率
-	cascade->det_ratio = 1;	// 当前检测率
-	link_list_init(&cascade->adaboost);
-
-	num_t m;		// 训练集样本数量
-	num_t l;		// 验证集样本数量
-	num_t sp_len = face + non_face;	// 样本集总数量
-	struct cas_sample sample;
-	if (!init_samples(&sample, img_size, face, non_face, args, get_face,
-			  get_non_face))
-		return false;
-#ifdef LOG
-	printf("Training start.\n");
-#endif
-	while (true) {
-		ada_det_ratio = d;
-		ada_f_p_ratio = f;
-		m = sp_len * train_pct;
-		l = sp_len - m;
-		if ((adaboost = malloc(sizeof(struct haar_adaboost))) == NULL)
-			goto new_ab_err;
-		if (!hl->train(adaboost, &ada_det_ratio, &ada_f_p_ratio, l, m,
-			       img_size, img_size, (void *)sample.X,
-			       (void *)sample.X2, sample.Y, &hl->wl_hl))
-			goto train_ab_err;
-		if (ada_f_p_ratio > f) {
-			hl->free(adaboost, &hl->wl_hl);
-			free(adaboost);
-			break;
-		}
-		if (!link_list_append(&cascade->adaboost, adaboost))
-			goto append_err;
-		// 更新当前假阳率、检测率
-		cascade->f_p_ratio *= ada_f_p_ratio;
-		cascade->det_ratio *= ada_det_ratio;
-#ifdef LOG
-		printf("Current detection ratio: %f\n", cascade->det_ratio);
-		printf("Current false positive ratio: %f\n",
-		       cascade->f_p_ratio);
-		printf("Target maximum false positive ratio: %f\n", F);
-#endif
-		if (cascade->f_p_ratio < F)		// 退出条件
-			break;
-		// 调整样本
-		if (!update_samples
-		    (&sample, &sp_len, args, img_size, get_non_face, cascade,
-		     hl))
-			goto update_err;
-	}
-#ifdef LOG
-	printf("Training end.\n");
-#endif
-	free_samples(&sample, sp_len);
-	return true;
+	return train(cascade, NULL, d, f, F, train_pct, face, non_face,
+		     img_size, args, get_face, get_non_face, hl);
+}
 
-append_err:
-	hl->free(adaboost, &hl->wl_hl);
-train_ab_err:
-	free(adaboost);
-update_err:
-new_ab_err:
-	free_samples(&sample, sp_len);
-	cas_free(cascade, hl);
-	return false;
+bool cas_train_resume(struct cascade *cascade, const char *ckpt, flt_t d,
+		      flt_t f, flt_t F, flt_t train_pct, num_t face,
+		      num_t non_face, imgsz_t img_size, void *args,
+		      cas_face_fn get_face, cas_non_face_fn get_non_face,
+		      struct haar_ada_handles *hl)
+{
+	return train(cascade, ckpt, d, f, F, train_pct, face, non_face,
+		     img_size, args, get_face, get_non_face, hl);
 }
 
 bool cas_write(const struct cascade * cascade, FILE * file,
@@ -164,33 +362,106 @@ flt_t IoU(const struct cas_rect *rect1, const struct cas_rect *rect2)
 	struct cas_rect intersection;
 	intersection.start_x = MAX(rect1->start_x, rect2->start_x);
 	intersection.start_y = MAX(rect1->start_y, rect2->start_y);
-	intersection.len =
-	    MIN(rect1->start_x + rect1->len,
-		  rect2->start_x + rect2->len) - intersection.start_x;
-	if (intersection.len < 0)
+	imgsz_t inter_w = MIN(rect1->start_x + rect1->len,
+			      rect2->start_x + rect2->len) - intersection.start_x;
+	imgsz_t inter_h = MIN(rect1->start_y + rect1->len,
+			      rect2->start_y + rect2->len) - intersection.start_y;
+	if (inter_w <= 0 || inter_h <= 0)
 		return 0;
-	flt_t s1 = rect1->len * rect1->len;
-	flt_t s2 = rect2->len * rect2->len;
-	flt_t s = intersection.len * intersection.len;
-	return (flt_t) s / (s1 + s2 - s);
+	flt_t s1 = (flt_t) rect1->len * rect1->len;
+	flt_t s2 = (flt_t) rect2->len * rect2->len;
+	flt_t s = (flt_t) inter_w * inter_h;
+	return s / (s1 + s2 - s);
 }
 
 flt_t cas_h(const struct cascade * cascade, imgsz_t n, imgsz_t wid,
 	    const flt_t x[n][wid], const flt_t x2[n][wid],
 	    const struct haar_ada_handles * hl)
 {
-	flt_t scale = (flt_t) n / cascade->img_size;
-	flt_t result;
-	struct haar_adaboost *adaboost = NULL;
-	link_iter iter = link_list_start_iter(&cascade->adaboost);
-	while (link_list_check_end(iter)) {
+	num_t passed;
+	return cascade_h(cascade, n, wid, x, x2, hl, &passed);
+}
+
+bool cas_compiled_init(struct cas_compiled *cc, const struct cascade *cascade)
+{
+	num_t wl_ct = 0;
+	const struct haar_adaboost *adaboost;
+	link_iter iter;
+
+	cc->len = 0;
+	cc->stage_ct = 0;
+	for (iter = link_list_start_iter(&cascade->adaboost);
+	     link_list_check_end(iter); link_list_next_iter(&iter)) {
 		adaboost = link_list_get_data(iter);
-		if ((result = hl->h(adaboost, n, n, wid, x, x2, scale,
-				    &hl->wl_hl)) < 0)
-			return result;
-		link_list_next_iter(&iter);
+		wl_ct += pack_array_size(&adaboost->wl);
+		++cc->stage_ct;
 	}
-	return result;
+	cc->stage = malloc(sizeof(struct cas_stage) * cc->stage_ct);
+	cc->wl = malloc(sizeof(struct wl_haar_compiled) * wl_ct);
+	cc->trace = malloc(sizeof(flt_t) * wl_ct);
+	if (cc->stage == NULL || cc->wl == NULL || cc->trace == NULL) {
+		cas_compiled_free(cc);
+		return false;
+	}
+
+	num_t i = 0;
+	wl_ct = 0;
+	for (iter = link_list_start_iter(&cascade->adaboost);
+	     link_list_check_end(iter); link_list_next_iter(&iter), ++i) {
+		adaboost = link_list_get_data(iter);
+		cc->stage[i].begin = wl_ct;
+		wl_ct += pack_array_size(&adaboost->wl);
+		cc->stage[i].end = wl_ct;
+		cc->stage[i].threshold = adaboost->threshold;
+		for (num_t k = cc->stage[i].begin; k < wl_ct; ++k)
+			cc->trace[k] = (adaboost->trace != NULL) ?
+			    adaboost->trace[k - cc->stage[i].begin] : -DBL_MAX;
+	}
+	return true;
+}
+
+bool cas_compile(struct cas_compiled *cc, const struct cascade *cascade,
+		 imgsz_t len, imgsz_t wid, const struct haar_ada_handles *hl)
+{
+	flt_t scale = (flt_t) len / cascade->img_size;
+	num_t i = 0;
+
+	cc->len = 0;
+	if (hl->compile == NULL)
+		return false;
+	link_iter iter = link_list_start_iter(&cascade->adaboost);
+	for (; link_list_check_end(iter); link_list_next_iter(&iter), ++i)
+		if (!hl->compile(cc->wl + cc->stage[i].begin,
+				 link_list_get_data(iter), wid, scale,
+				 &hl->wl_hl))
+			return false;
+
+	// 第一行、第一列弃置不用（同 get_std_dev()）
+	cc->corner[0] = len - 1;
+	cc->corner[1] = (ptrdiff_t) (len - 1) * wid;
+	cc->corner[2] = cc->corner[1] + cc->corner[0];
+	cc->area = (len - 1) * (len - 1);
+	cc->len = len;
+	cc->wid = wid;
+	return true;
+}
+
+void cas_compiled_free(struct cas_compiled *cc)
+{
+	free(cc->stage);
+	free(cc->wl);
+	free(cc->trace);
+	cc->stage = NULL;
+	cc->wl = NULL;
+	cc->trace = NULL;
+	cc->len = 0;
+}
+
+flt_t cas_compiled_h(const struct cas_compiled *cc, const flt_t * x,
+		     const flt_t * x2)
+{
+	num_t passed;
+	return compiled_h(cc, x, x2, &passed);
 }
 
 flt_t cas_nextobj(const struct cascade * cascade, struct cas_rect * rect,
@@ -203,6 +474,11 @@ flt_t cas_nextobj(const struct cascade * cascade, struct cas_rect * rect,
 	const void *x2_start = NULL;
 
 	imgsz_t min_size = (h > w) ? w : h;
+	// 统计各尺度的窗口数：由窗口边长推算尺度编号
+	CAS_PROF(num_t scale = 0);
+	CAS_PROF(unsigned long windows = 0);
+	CAS_PROF(for (imgsz_t len = cascade->img_size; len < rect->len;
+		      len *= scale_times) ++scale);
 	rect->start_x += *delta;
 	while (rect->len < min_size) {
 		while (rect->start_y <= h - rect->len) {
@@ -212,13 +488,19 @@ flt_t cas_nextobj(const struct cascade * cascade, struct cas_rect * rect,
 				result =
 				    cas_h(cascade, rect->len, w, x_start,
 					  x2_start, hl);
-				if (result > 0)
+				CAS_PROF(++windows);
+				if (result > 0) {
+					CAS_PROF(cas_prof_scale(scale, rect->len,
+								windows));
 					return result;
+				}
 				rect->start_x += *delta;
 			}
 			rect->start_x = 0;
 			rect->start_y += *delta;
 		}
+		CAS_PROF(cas_prof_scale(scale++, rect->len, windows));
+		CAS_PROF(windows = 0);
 		rect->start_y = 0;
 		rect->len *= scale_times;
 		*delta *= scale_times;
@@ -231,42 +513,921 @@ struct link_list cas_detect(const struct cascade *cascade, imgsz_t h,
 			    imgsz_t w, unsigned char img[h][w], imgsz_t delta,
 			    const struct haar_ada_handles *hl)
 {
-	imgsz_t i, j;
+	struct cas_det_param param;
 	struct link_list list;
-	struct cas_det_rect *rect_ptr = NULL;
-	struct cas_det_rect rect = { {0, 0, cascade->img_size}, 0 };
-	flt_t x[h][w];
-	flt_t x2[h][w];
+	struct cas_det_rect *rect_ptr;
+	cas_det_param_default(&param);
+	param.delta = delta;
 
-	for (i = 0; i < h; ++i)
-		for (j = 0; j < w; ++j) {
-			x[i][j] = img[i][j];
-			x2[i][j] = img[i][j];
-		}
-	intgraph(h, w, x);
-	intgraph2(h, w, x2);
-
-	// 构建一个由所有可能含有目标的边框构成的链表
 	link_list_init(&list);
-	while ((rect.confidence = cas_nextobj(cascade, &rect.rect, &delta,
-					      h, w, x, x2, hl)) > 0) {
-		rect_ptr = malloc(sizeof(struct cas_det_rect));
-		if (rect_ptr == NULL)
-			return list;
-		*rect_ptr = rect;
+	struct cas_det_array det = cas_detect_ex(cascade, h, w, img, &param,
+						 hl);
+	for (size_t i = 0; i < det.size; ++i) {
+		if ((rect_ptr = malloc(sizeof(struct cas_det_rect))) == NULL)
+			break;
+		*rect_ptr = det.rect[i];
 		if (!link_list_append(&list, rect_ptr)) {
 			free(rect_ptr);
-			return list;
+			break;
 		}
 	}
-	// 删除重叠窗口
-	NMS(&list, 0.1);
+	cas_det_array_free(&det);
 	return list;
 }
 
+void cas_det_array_free(struct cas_det_array *arr)
+{
+	free(arr->rect);
+	arr->rect = NULL;
+	arr->size = 0;
+}
+
+void cas_det_param_default(struct cas_det_param *param)
+{
+	param->delta = 1;
+	param->threads = 1;
+	param->mode = CAS_SCAN_FEATURE;
+	param->roi_margin = 0.5;
+	param->roi_scales = 1;
+	param->adaptive = false;
+	param->skip_score = -2;
+	param->skip_max = 2;
+	param->dense_stage = 2;
+}
+
+struct cas_det_array cas_detect_ex(const struct cascade *cascade, imgsz_t h,
+				   imgsz_t w, unsigned char img[h][w],
+				   const struct cas_det_param *param,
+				   const struct haar_ada_handles *hl)
+{
+	struct cas_det_array arr = { NULL, 0 };
+	struct cas_detector *det = cas_detector_new(cascade, h, w, param, hl);
+	size_t n;
+	if (det == NULL)
+		return arr;
+
+	// 直接取走检测器中的结果
+	if (cas_detector_run(det, h, w, (const void *)img, NULL, 0, NULL, 0, &n)
+	    && n > 0) {
+		arr = det->det;
+		det->det.rect = NULL;
+	}
+	cas_detector_free(det);
+	return arr;
+}
+
+struct cas_detector *cas_detector_new(const struct cascade *cascade,
+				      imgsz_t max_h, imgsz_t max_w,
+				      const struct cas_det_param *param,
+				      const struct haar_ada_handles *hl)
+{
+	const flt_t scale_times = 1.25;
+	imgsz_t min_size = MIN(max_h, max_w);
+	imgsz_t len = cascade->img_size;
+	imgsz_t d = param->delta;
+	num_t scale_ct = 0, k;
+	size_t row_ct = 0;
+	struct cas_detector *det;
+
+	if (param->delta <= 0 || max_h <= 0 || max_w <= 0)
+		return NULL;
+	// 跳过的窗口数为得分与 skip_score 之比，skip_score 非负时该值为负或无穷
+	if (param->adaptive && (!(param->skip_score < 0)
+				|| param->skip_max < 0))
+		return NULL;
+	if ((det = calloc(1, sizeof(struct cas_detector))) == NULL)
+		return NULL;
+	det->cascade = cascade;
+	det->hl = hl;
+	det->param = *param;
+	det->max_h = max_h;
+	det->max_w = max_w;
+	det->x = malloc(sizeof(flt_t) * 2 * max_h * max_w);
+	if (det->x == NULL)
+		goto err;
+	det->x2 = det->x + (size_t) max_h * max_w;
+
+	// 确定所有尺度（同 cas_nextobj()），并预先编译
+	for (; len < min_size; len *= scale_times)
+		++scale_ct;
+	if ((det->scales = calloc(scale_ct + 1, sizeof(struct scan_scale)))
+	    == NULL)
+		goto err;
+	len = cascade->img_size;
+	for (k = 0; k < scale_ct; ++k, len *= scale_times, d *= scale_times) {
+		struct scan_scale *sc = &det->scales[k];
+		if (!init_scale(sc, det, len, d))
+			goto err;
+		det->scale_cap = k + 1;
+		row_ct += (sc->h - sc->win) / sc->delta + 1;
+	}
+	// 与 cas_nextobj() 一致：放大特征时，首次扫描从第二个窗口开始
+	if (param->mode == CAS_SCAN_FEATURE && scale_ct > 0)
+		det->scales[0].skip = det->scales[0].delta;
+	if (!RESERVE(det->rows, det->row_cap, row_ct))
+		goto err;
+
+	if ((det->pool = cas_pool_new(param->threads)) == NULL)
+		goto err;
+	det->threads = cas_pool_threads(det->pool);
+	det->found = malloc(sizeof(struct pack_array) * det->threads);
+	det->failed = malloc(sizeof(bool) * det->threads);
+	det->stat = calloc(det->threads, sizeof(struct cas_scan_stat));
+	if (det->found == NULL || det->failed == NULL || det->stat == NULL)
+		goto err;
+	for (unsigned int i = 0; i < det->threads; ++i)
+		pack_array_init(&det->found[i], sizeof(struct cas_det_rect));
+	return det;
+
+err:
+	cas_detector_free(det);
+	return NULL;
+}
+
+void cas_detector_free(struct cas_detector *det)
+{
+	if (det == NULL)
+		return;
+	for (num_t k = 0; k < det->scale_cap; ++k) {
+		if (det->scales[k].compiled)
+			cas_compiled_free(&det->scales[k].cc);
+		free(det->scales[k].buf);
+	}
+	if (det->found != NULL)
+		for (unsigned int i = 0; i < det->threads; ++i)
+			pack_array_free_full(&det->found[i], NULL);
+	cas_pool_free(det->pool);
+	free(det->scales);
+	free(det->rows);
+	free(det->found);
+	free(det->failed);
+	free(det->stat);
+	free(det->x);
+	cas_det_array_free(&det->det);
+	free(det->removed);
+	free(det->start);
+	free(det->item);
+	free(det);
+}
+
+bool cas_detector_run(struct cas_detector *det, imgsz_t h, imgsz_t w,
+		      const unsigned char img[h][w],
+		      const struct cas_det_rect roi[], size_t roi_ct,
+		      struct cas_det_rect out[], size_t cap, size_t *n)
+{
+	num_t k;
+
+	*n = 0;
+	CAS_PROF(double t0 = cas_prof_now());
+	if (!load_frame(det, h, w, img))
+		return false;
+	CAS_PROF(cas_prof_time(CAS_PROF_INTGRAPH, t0));
+	det->row_ct = 0;
+	if (!(roi_ct == 0 ? full_rows(det) : roi_rows(det, roi, roi_ct)))
+		return false;
+	// 仅构建有任务的图像金字塔层
+	CAS_PROF(t0 = cas_prof_now());
+	for (k = 0; k < det->scale_ct; ++k)
+		if (det->scales[k].used && det->scales[k].buf != NULL)
+			build_level(&det->scales[k], det);
+	CAS_PROF(cas_prof_time(CAS_PROF_INTGRAPH, t0));
+
+	// 各线程将目标保存到私有缓冲区，完成后合并
+	for (unsigned int t = 0; t < det->threads; ++t) {
+		pack_array_clear(&det->found[t]);
+		det->failed[t] = false;
+	}
+	CAS_PROF(t0 = cas_prof_now());
+	cas_pool_exec(det->pool, det->row_ct, scan_row, det);
+	CAS_PROF(cas_prof_time(CAS_PROF_SCAN, t0));
+	for (unsigned int t = 0; t < det->threads; ++t)
+		if (det->failed[t])
+			return false;
+
+	// 删除重叠窗口
+	CAS_PROF(t0 = cas_prof_now());
+	if (!merge(det))
+		return false;
+	CAS_PROF(unsigned long raw_det = det->det.size);
+	if (!NMS(det, 0.1))
+		return false;
+	CAS_PROF(cas_prof_time(CAS_PROF_NMS, t0));
+	CAS_PROF(cas_prof_image(raw_det, det->det.size));
+	*n = det->det.size;
+	if (MIN(cap, *n) > 0)
+		memcpy(out, det->det.rect,
+		       sizeof(struct cas_det_rect) * MIN(cap, *n));
+	return true;
+}
+
+bool cas_detector_mine(struct cas_detector *det, imgsz_t h, imgsz_t w,
+		       const unsigned char img[h][w], struct train_ctx *rng,
+		       cas_mine_fn sink, void *args)
+{
+	struct cas_rect rect;
+	flt_t result;
+	num_t k, passed;
+
+	if (!load_frame(det, h, w, img))
+		return false;
+	// 各尺度的窗口编号连续，end[k] 为第 k 个尺度之后的第一个编号
+	size_t cols[det->scale_ct + 1], end[det->scale_ct + 1], total = 0;
+	for (k = 0; k < det->scale_ct; ++k) {
+		struct scan_scale *sc = &det->scales[k];
+		cols[k] = 0;
+		if (sc->h >= sc->win && sc->w >= sc->win) {
+			cols[k] = (sc->w - sc->win) / sc->delta + 1;
+			total += cols[k] * ((sc->h - sc->win) / sc->delta + 1);
+			if (sc->buf != NULL)
+				build_level(sc, det);
+		}
+		end[k] = total;
+	}
+	if (total == 0)
+		return true;
+
+	// 随机起点及与窗口总数互素的随机步长
+	size_t pos = train_next(rng) % total;
+	size_t step = 1;
+	while (total > 1) {
+		step = train_next(rng) % (total - 1) + 1;
+		size_t a = total, b = step;
+		while (b != 0) {
+			size_t r = a % b;
+			a = b;
+			b = r;
+		}
+		if (a == 1)
+			break;
+	}
+
+	for (size_t t = 0; t < total; ++t, pos = (pos + step) % total) {
+		for (k = 0; pos >= end[k]; ++k) ;
+		const struct scan_scale *sc = &det->scales[k];
+		const flt_t(*x)[sc->stride] = (const void *)sc->x;
+		const flt_t(*x2)[sc->stride] = (const void *)sc->x2;
+		size_t r = pos - (k == 0 ? 0 : end[k - 1]);
+		imgsz_t i = r / cols[k] * sc->delta;
+		imgsz_t j = r % cols[k] * sc->delta;
+		// 与全图扫描一致，跳过首行的前若干窗口
+		if (i == 0 && j < sc->skip)
+			continue;
+
+		result = sc->compiled ?
+		    compiled_h(&sc->cc, &x[i][j], &x2[i][j], &passed) :
+		    cascade_h(det->cascade, sc->win, sc->stride,
+			      (const void *)&x[i][j], (const void *)&x2[i][j],
+			      det->hl, &passed);
+		if (result <= 0)
+			continue;
+		rect.start_x = j * sc->rate;
+		rect.start_y = i * sc->rate;
+		rect.len = sc->len;
+		if (!sink(&rect, args))
+			break;
+	}
+	return true;
+}
+
+void cas_detector_get_stat(const struct cas_detector *det,
+			   struct cas_scan_stat *stat)
+{
+	memset(stat, 0, sizeof(*stat));
+	for (unsigned int t = 0; t < det->threads; ++t) {
+		stat->grid += det->stat[t].grid;
+		stat->windows += det->stat[t].windows;
+		stat->skipped += det->stat[t].skipped;
+		stat->dense += det->stat[t].dense;
+	}
+}
+
+void cas_detector_reset_stat(struct cas_detector *det)
+{
+	memset(det->stat, 0, sizeof(struct cas_scan_stat) * det->threads);
+}
+
+bool cas_detect_batch(const struct cascade *cascade, size_t n,
+		      const struct cas_batch_image imgs[],
+		      const struct cas_det_param *param,
+		      const struct haar_ada_handles *hl,
+		      struct cas_det_array res[])
+{
+	struct cas_det_param single = *param;
+	struct cas_pool *pool = NULL;
+	struct batch_args args = { NULL, imgs, res, NULL };
+	imgsz_t max_h = 0, max_w = 0;
+	unsigned int threads = 0, t;
+	size_t i;
+	bool ok = false;
+
+	for (i = 0; i < n; ++i) {
+		res[i] = (struct cas_det_array) { NULL, 0 };
+		max_h = MAX(max_h, imgs[i].h);
+		max_w = MAX(max_w, imgs[i].w);
+	}
+	if (max_h <= 0 || max_w <= 0)
+		return true;
+
+	// 各检测器单线程检测，并行在图像之间进行
+	if ((pool = cas_pool_new(param->threads)) == NULL)
+		return false;
+	threads = cas_pool_threads(pool);
+	single.threads = 1;
+	args.det = calloc(threads, sizeof(struct cas_detector *));
+	args.failed = calloc(threads, sizeof(bool));
+	if (args.det == NULL || args.failed == NULL)
+		goto clean;
+	for (t = 0; t < threads; ++t)
+		if ((args.det[t] = cas_detector_new(cascade, max_h, max_w,
+						    &single, hl)) == NULL)
+			goto clean;
+
+	cas_pool_exec(pool, n, batch_image, &args);
+	ok = true;
+	for (t = 0; t < threads; ++t)
+		ok = ok && !args.failed[t];
+	if (!ok)
+		for (i = 0; i < n; ++i)
+			cas_det_array_free(&res[i]);
+
+clean:
+	if (args.det != NULL)
+		for (t = 0; t < threads; ++t)
+			cas_detector_free(args.det[t]);
+	free(args.det);
+	free(args.failed);
+	cas_pool_free(pool);
+	return ok;
+}
+
 /*******************************************************************************
  * 				  静态函数实现
  ******************************************************************************/
+bool train(struct cascade *cascade, const char *ckpt, flt_t d, flt_t f,
+	   flt_t F, flt_t train_pct, num_t face, num_t non_face,
+	   imgsz_t img_size, void *args, cas_face_fn get_face,
+	   cas_non_face_fn get_non_face, struct haar_ada_handles *hl)
+{
+	struct haar_adaboost *adaboost = NULL;	// Adaboost 地址
+	flt_t ada_f_p_ratio;	// AdaBoost 假阳率
+	flt_t ada_det_ratio;	// AdaBoost 检测率
+	struct ckpt_param cp = { d, f, F, train_pct, face, non_face, img_size };
+	bool resumed = false;	// 是否从检查点恢复
+	bool trained;		// 本级 Adaboost 是否训练成功
+
+	num_t m;		// 训练集样本数量
+	num_t l;		// 验证集样本数量
+	num_t sp_len = face + non_face;	// 样本集总数量
+	struct cas_sample sample;
+	if (ckpt != NULL && !load_ckpt(ckpt, &cp, cascade, &sample, &sp_len,
+				       hl, &resumed))
+		return false;
+	if (!resumed) {
+		cascade->img_size = img_size;	// 设置图像尺寸
+		cascade->f_p_ratio = 1;	// 当前假阳率
+		cascade->det_ratio = 1;	// 当前检测率
+		link_list_init(&cascade->adaboost);
+		if (!init_samples(&sample, img_size, face, non_face, args,
+				  get_face, get_non_face, hl->wl_hl.ctx))
+			return false;
+	}
+#ifdef LOG
+	printf(resumed ? "Training resumed.\n" : "Training start.\n");
+#endif
+	while (true) {
+		// 刚恢复时检查点即为当前状态，无需重复写入
+		if (ckpt != NULL && !resumed
+		    && !save_ckpt(ckpt, &cp, cascade, &sample, sp_len, hl))
+			goto ckpt_err;
+		resumed = false;
+		ada_det_ratio = d;
+		ada_f_p_ratio = f;
+		m = sp_len * train_pct;
+		l = sp_len - m;
+		split_samples(&sample, sp_len, l);
+		if ((adaboost = malloc(sizeof(struct haar_adaboost))) == NULL)
+			goto new_ab_err;
+		// 训练时对样本的扫描同样按样本存储的预算分块驻留
+		stream_samples(&sample, hl->wl_hl.ctx, true);
+		trained = hl->train(adaboost, &ada_det_ratio, &ada_f_p_ratio, l,
+				    m, img_size, img_size, sample.PX,
+				    sample.PX2, sample.PY, &hl->wl_hl);
+		stream_samples(&sample, hl->wl_hl.ctx, false);
+		if (!trained)
+			goto train_ab_err;
+		if (ada_f_p_ratio > f) {
+			hl->free(adaboost, &hl->wl_hl);
+			free(adaboost);
+			break;
+		}
+		if (!link_list_append(&cascade->adaboost, adaboost))
+			goto append_err;
+		// 更新当前假阳率、检测率
+		cascade->f_p_ratio *= ada_f_p_ratio;
+		cascade->det_ratio *= ada_det_ratio;
+#ifdef LOG
+		printf("Current detection ratio: %f\n", cascade->det_ratio);
+		printf("Current false positive ratio: %f\n",
+		       cascade->f_p_ratio);
+		printf("Target maximum false positive ratio: %f\n", F);
+#endif
+		if (cascade->f_p_ratio < F)		// 退出条件
+			break;
+		// 调整样本
+		if (!update_samples
+		    (&sample, &sp_len, args, img_size, get_non_face, cascade,
+		     hl))
+			goto update_err;
+	}
+#ifdef LOG
+	printf("Training end.\n");
+#endif
+	free_samples(&sample, sp_len);
+	return true;
+
+append_err:
+	hl->free(adaboost, &hl->wl_hl);
+train_ab_err:
+	free(adaboost);
+update_err:
+new_ab_err:
+ckpt_err:
+	free_samples(&sample, sp_len);
+	cas_free(cascade, hl);
+	return false;
+}
+
+bool save_ckpt(const char *path, const struct ckpt_param *cp,
+	       const struct cascade *cascade, const struct cas_sample *sp,
+	       num_t sp_len, const struct haar_ada_handles *hl)
+{
+	char tmp[strlen(path) + sizeof(".tmp")];
+	const struct train_ctx *ctx = train_ctx_get(hl->wl_hl.ctx);
+	FILE *file;
+	bool ok;
+
+	strcpy(tmp, path);
+	strcat(tmp, ".tmp");
+	if ((file = fopen(tmp, "wb")) == NULL)
+		return false;
+	ok = fwrite(&cp->d, sizeof(flt_t), 1, file) == 1
+	    && fwrite(&cp->f, sizeof(flt_t), 1, file) == 1
+	    && fwrite(&cp->F, sizeof(flt_t), 1, file) == 1
+	    && fwrite(&cp->train_pct, sizeof(flt_t), 1, file) == 1
+	    && fwrite(&cp->face, sizeof(num_t), 1, file) == 1
+	    && fwrite(&cp->non_face, sizeof(num_t), 1, file) == 1
+	    && fwrite(&cp->img_size, sizeof(imgsz_t), 1, file) == 1
+	    && fwrite(ctx->s, sizeof(ctx->s), 1, file) == 1
+	    && cas_write(cascade, file, hl)
+	    && write_samples(sp, sp_len, cp->img_size, file);
+	ok = (fclose(file) == 0) && ok;
+	if (ok)
+		ok = rename(tmp, path) == 0;
+	else
+		remove(tmp);
+#ifdef LOG
+	if (ok)
+		printf("Checkpoint saved: %u stage(s).\n",
+		       link_list_size(&cascade->adaboost));
+#endif
+	return ok;
+}
+
+bool load_ckpt(const char *path, const struct ckpt_param *cp,
+	       struct cascade *cascade, struct cas_sample *sp, num_t *sp_len,
+	       const struct haar_ada_handles *hl, bool *found)
+{
+	uint64_t s[4];
+	FILE *file;
+
+	*found = false;
+	if ((file = fopen(path, "rb")) == NULL)
+		return true;
+	link_list_init(&cascade->adaboost);
+	if (!CKPT_SAME(file, flt_t, cp->d) || !CKPT_SAME(file, flt_t, cp->f)
+	    || !CKPT_SAME(file, flt_t, cp->F)
+	    || !CKPT_SAME(file, flt_t, cp->train_pct)
+	    || !CKPT_SAME(file, num_t, cp->face)
+	    || !CKPT_SAME(file, num_t, cp->non_face)
+	    || !CKPT_SAME(file, imgsz_t, cp->img_size)
+	    || fread(s, sizeof(s), 1, file) < 1)
+		goto err;
+	if (!cas_read(cascade, file, hl)) {
+		cas_free(cascade, hl);
+		goto err;
+	}
+	if (!read_samples(sp, sp_len, cp->img_size, file)) {
+		cas_free(cascade, hl);
+		goto err;
+	}
+	fclose(file);
+	memcpy(train_ctx_get(hl->wl_hl.ctx)->s, s, sizeof(s));
+	*found = true;
+	return true;
+
+err:
+	fclose(file);
+	return false;
+}
+
+flt_t cascade_h(const struct cascade *cascade, imgsz_t n, imgsz_t wid,
+		const flt_t x[n][wid], const flt_t x2[n][wid],
+		const struct haar_ada_handles *hl, num_t *passed)
+{
+	flt_t scale = (flt_t) n / cascade->img_size;
+	flt_t result;
+	struct haar_adaboost *adaboost = NULL;
+	link_iter iter = link_list_start_iter(&cascade->adaboost);
+	// 窗口标准差对所有弱学习器都相同，只计算一次
+	bool using_std = hl->h_std != NULL && hl->wl_hl.hypothesis_std != NULL;
+	flt_t std_dev = using_std ? wl_haar_std_dev(n, n, wid, x, x2) : 0;
+	num_t stage = 0;
+	CAS_PROF(unsigned long wl = 0);
+	while (link_list_check_end(iter)) {
+		adaboost = link_list_get_data(iter);
+		result = using_std ?
+		    hl->h_std(adaboost, wid, x, std_dev, scale, &hl->wl_hl) :
+		    hl->h(adaboost, n, n, wid, x, x2, scale, &hl->wl_hl);
+		CAS_PROF(wl += pack_array_size(&adaboost->wl));
+		if (result < 0) {
+			CAS_PROF(cas_prof_window(stage + 1, stage, wl));
+			*passed = stage;
+			return result;
+		}
+		++stage;
+		link_list_next_iter(&iter);
+	}
+	CAS_PROF(cas_prof_window(stage, stage, wl));
+	*passed = stage;
+	return result;
+}
+
+flt_t compiled_h(const struct cas_compiled *cc, const flt_t * x,
+		 const flt_t * x2, num_t *passed)
+{
+	flt_t std_dev;		// 标准差
+	std_dev = (flt_t) (x[cc->corner[2]] - x[cc->corner[1]]
+			   - x[cc->corner[0]] + x[0]) / cc->area;
+	std_dev *= -std_dev;
+	std_dev += (flt_t) (x2[cc->corner[2]] - x2[cc->corner[1]]
+			    - x2[cc->corner[0]] + x2[0]) / cc->area;
+	if (std_dev != 0)
+		std_dev = sqrt(std_dev);
+
+	flt_t result = 0;
+	const struct wl_haar_compiled *wl;
+	const flt_t *trace = cc->trace;
+	for (num_t i = 0; i < cc->stage_ct; ++i) {
+		flt_t total = 0;
+		const struct wl_haar_compiled *end = cc->wl + cc->stage[i].end;
+		for (wl = cc->wl + cc->stage[i].begin; wl < end; ++wl, ++trace) {
+			// 方差为 0 时哈尔特征为 0（同 get_value()）
+			if (std_dev == 0) {
+				total += wl->output[0 >= wl->value];
+			} else {
+				flt_t raw = 0;
+				for (num_t k = 0; k < wl->n; ++k)
+					raw += wl->weight[k] * x[wl->offset[k]];
+				total += wl->output[raw >= wl->value * std_dev];
+			}
+			// 软级联：部分和低于拒绝阈值时提前拒绝
+			if (total < *trace) {
+				CAS_PROF(cas_prof_window(i + 1, i,
+							 wl - cc->wl + 1));
+				*passed = i;
+				return total - *trace;
+			}
+		}
+		if ((result = total - cc->stage[i].threshold) < 0) {
+			CAS_PROF(cas_prof_window(i + 1, i, cc->stage[i].end));
+			*passed = i;
+			return result;
+		}
+	}
+	*passed = cc->stage_ct;
+	CAS_PROF(cas_prof_window(cc->stage_ct, cc->stage_ct, cc->stage_ct ?
+				 cc->stage[cc->stage_ct - 1].end : 0));
+	return result;
+}
+
+bool init_scale(struct scan_scale *sc, const struct cas_detector *det,
+		imgsz_t len, imgsz_t delta)
+{
+	sc->len = len;
+	sc->skip = 0;
+	sc->buf = NULL;
+	sc->used = false;
+	if (det->param.mode == CAS_SCAN_FEATURE
+	    || len == det->cascade->img_size) {
+		// 在原图像上扫描
+		sc->rate = 1;
+		sc->h = det->max_h;
+		sc->w = sc->stride = det->max_w;
+		sc->x = det->x;
+		sc->x2 = det->x2;
+		sc->win = len;
+		sc->delta = delta;
+	} else {
+		// 图像金字塔中的一层，按最大帧申请缓冲区
+		sc->rate = (flt_t) len / det->cascade->img_size;
+		sc->h = det->max_h / sc->rate;
+		sc->w = sc->stride = det->max_w / sc->rate;
+		sc->win = det->cascade->img_size;
+		sc->delta = delta / sc->rate + 0.5;
+		if (sc->delta < 1)
+			sc->delta = 1;
+		if ((sc->buf = malloc(sizeof(flt_t) * 2 * sc->h * sc->w)) == NULL)
+			return false;
+		sc->x = sc->buf;
+		sc->x2 = sc->buf + (size_t) sc->h * sc->w;
+	}
+
+	// 编译失败时逐窗口调用 cas_h()
+	sc->compiled = cas_compiled_init(&sc->cc, det->cascade);
+	if (sc->compiled && !cas_compile(&sc->cc, det->cascade, sc->win,
+					 sc->stride, det->hl)) {
+		cas_compiled_free(&sc->cc);
+		sc->compiled = false;
+	}
+	return true;
+}
+
+bool load_frame(struct cas_detector *det, imgsz_t h, imgsz_t w,
+		const unsigned char img[h][w])
+{
+	flt_t(*x)[det->max_w] = (void *)det->x;
+	flt_t(*x2)[det->max_w] = (void *)det->x2;
+	imgsz_t min_size = MIN(h, w);
+	imgsz_t i, j;
+	num_t k;
+
+	if (h <= 0 || w <= 0 || h > det->max_h || w > det->max_w)
+		return false;
+	det->h = h;
+	det->w = w;
+	det->img = &img[0][0];
+	for (i = 0; i < h; ++i)
+		for (j = 0; j < w; ++j)
+			x[i][j] = x2[i][j] = img[i][j];
+	intgraph_ex(h, w, det->max_w, x);
+	intgraph2_ex(h, w, det->max_w, x2);
+
+	// 当前帧的尺度为最大帧各尺度的前缀
+	for (k = 0; k < det->scale_cap && det->scales[k].len < min_size; ++k)
+		frame_scale(&det->scales[k], det);
+	det->scale_ct = k;
+	return true;
+}
+
+void frame_scale(struct scan_scale *sc, const struct cas_detector *det)
+{
+	sc->used = false;
+	if (sc->buf == NULL) {
+		sc->h = det->h;
+		sc->w = det->w;
+	} else {
+		sc->h = det->h / sc->rate;
+		sc->w = det->w / sc->rate;
+	}
+}
+
+void build_level(struct scan_scale *sc, const struct cas_detector *det)
+{
+	flt_t(*x)[sc->stride] = (void *)sc->x;
+	flt_t(*x2)[sc->stride] = (void *)sc->x2;
+	const unsigned char (*img)[det->w] = (const void *)det->img;
+	flt_t posi_i = 0, posi_j;
+	for (imgsz_t i = 0; i < sc->h; ++i, posi_i += sc->rate) {
+		posi_j = 0;
+		for (imgsz_t j = 0; j < sc->w; ++j, posi_j += sc->rate)
+			x[i][j] = x2[i][j] =
+			    img[(imgsz_t) posi_i][(imgsz_t) posi_j];
+	}
+	intgraph_ex(sc->h, sc->w, sc->stride, x);
+	intgraph2_ex(sc->h, sc->w, sc->stride, x2);
+}
+
+bool full_rows(struct cas_detector *det)
+{
+	size_t n = 0;
+	num_t k;
+	for (k = 0; k < det->scale_ct; ++k) {
+		const struct scan_scale *sc = &det->scales[k];
+		if (sc->h >= sc->win)
+			n += (sc->h - sc->win) / sc->delta + 1;
+	}
+	if (!RESERVE(det->rows, det->row_cap, n))
+		return false;
+
+	for (k = 0; k < det->scale_ct; ++k) {
+		const struct scan_scale *sc = &det->scales[k];
+		for (imgsz_t y = 0; y <= sc->h - sc->win; y += sc->delta)
+			push_row(det, k, y, (y == 0) ? sc->skip : 0,
+				 sc->w - sc->win);
+	}
+	return true;
+}
+
+bool roi_rows(struct cas_detector *det, const struct cas_det_rect roi[],
+	      size_t roi_ct)
+{
+	const flt_t scale_times = 1.25;
+	for (size_t r = 0; r < roi_ct; ++r) {
+		const struct cas_rect *rc = &roi[r].rect;
+		imgsz_t margin = rc->len * det->param.roi_margin;
+		// 扩展后的范围为 [left, right) × [top, bottom)（原图像坐标）
+		imgsz_t left = MAX(rc->start_x - margin, 0);
+		imgsz_t top = MAX(rc->start_y - margin, 0);
+		imgsz_t right = MIN(rc->start_x + rc->len + margin, det->w);
+		imgsz_t bottom = MIN(rc->start_y + rc->len + margin, det->h);
+		flt_t lo = rc->len, hi = rc->len;
+		for (num_t s = 0; s < det->param.roi_scales; ++s) {
+			lo /= scale_times;
+			hi *= scale_times;
+		}
+
+		for (num_t k = 0; k < det->scale_ct; ++k) {
+			const struct scan_scale *sc = &det->scales[k];
+			if (sc->len < lo || sc->len > hi)
+				continue;
+			// 换算到所扫描图像，并对齐到全图扫描的网格
+			imgsz_t x0 = ceil(left / sc->rate);
+			imgsz_t y0 = ceil(top / sc->rate);
+			x0 = (x0 + sc->delta - 1) / sc->delta * sc->delta;
+			y0 = (y0 + sc->delta - 1) / sc->delta * sc->delta;
+			imgsz_t x1 = MIN((imgsz_t) (right / sc->rate),
+					 sc->w) - sc->win;
+			imgsz_t y1 = MIN((imgsz_t) (bottom / sc->rate),
+					 sc->h) - sc->win;
+			if (x0 > x1)
+				continue;
+			for (imgsz_t y = y0; y <= y1; y += sc->delta)
+				if (!push_row(det, k, y, (y == 0) ?
+					      MAX(x0, sc->skip) : x0, x1))
+					return false;
+		}
+	}
+	return true;
+}
+
+bool push_row(struct cas_detector *det, num_t scale, imgsz_t y, imgsz_t x0,
+	      imgsz_t x1)
+{
+	if (!RESERVE(det->rows, det->row_cap, det->row_ct + 1))
+		return false;
+	det->rows[det->row_ct++] = (struct scan_row) { scale, y, x0, x1 };
+	det->scales[scale].used = true;
+	return true;
+}
+
+void scan_row(size_t task, unsigned int worker, void *args)
+{
+	struct cas_detector *det = args;
+	const struct cas_det_param *param = &det->param;
+	const struct scan_row *row = &det->rows[task];
+	const struct scan_scale *sc = &det->scales[row->scale];
+	struct cas_scan_stat *stat = &det->stat[worker];
+	// 邻域为到相邻网格窗口一半距离之内的范围，各网格窗口的邻域互不重叠
+	const imgsz_t lo = -(sc->delta - 1) / 2, hi = sc->delta / 2;
+	unsigned long windows = 0, dense = 0;
+	flt_t result;
+	num_t passed;
+
+	if (row->x0 > row->x1)
+		return;
+	stat->grid += (row->x1 - row->x0) / sc->delta + 1;
+	for (imgsz_t j = row->x0; j <= row->x1; j += sc->delta) {
+		if (!scan_window(det, sc, row->y, j, worker, &result, &passed))
+			return;
+		++windows;
+		if (!param->adaptive)
+			continue;
+
+		if (passed == 0 && result < param->skip_score) {
+			// 得分越低，跳过的窗口越多（不超过行末）；先在浮点数
+			// 上取上限再转换，避免得分极低时溢出
+			flt_t ratio = result / param->skip_score;
+			imgsz_t skip = (ratio < param->skip_max) ?
+			    (imgsz_t) ratio : param->skip_max;
+			skip = MIN(skip, (row->x1 - j) / sc->delta);
+			skip = MAX(skip, 0);
+			stat->skipped += skip;
+			j += skip * sc->delta;
+		} else if (passed >= param->dense_stage && sc->delta > 1) {
+			for (imgsz_t dy = lo; dy <= hi; ++dy) {
+				imgsz_t i = row->y + dy;
+				if (i < 0 || i > sc->h - sc->win)
+					continue;
+				for (imgsz_t dx = lo; dx <= hi; ++dx) {
+					if ((dx == 0 && dy == 0) || j + dx < 0
+					    || j + dx > sc->w - sc->win)
+						continue;
+					if (!scan_window(det, sc, i, j + dx,
+							 worker, &result,
+							 &passed))
+						return;
+					++dense;
+				}
+			}
+		}
+	}
+	stat->windows += windows + dense;
+	stat->dense += dense;
+	CAS_PROF(cas_prof_scale(row->scale, sc->len, windows + dense));
+}
+
+bool scan_window(struct cas_detector *det, const struct scan_scale *sc,
+		 imgsz_t i, imgsz_t j, unsigned int worker, flt_t *result,
+		 num_t *passed)
+{
+	const flt_t(*x)[sc->stride] = (const void *)sc->x;
+	const flt_t(*x2)[sc->stride] = (const void *)sc->x2;
+	struct cas_det_rect *rect;
+
+	*result = sc->compiled ?
+	    compiled_h(&sc->cc, &x[i][j], &x2[i][j], passed) :
+	    cascade_h(det->cascade, sc->win, sc->stride, (const void *)&x[i][j],
+		      (const void *)&x2[i][j], det->hl, passed);
+	if (*result <= 0)
+		return true;
+	if ((rect = pack_array_append(&det->found[worker])) == NULL) {
+		det->failed[worker] = true;
+		return false;
+	}
+	// 换算回原图像坐标
+	rect->rect.start_x = j * sc->rate;
+	rect->rect.start_y = i * sc->rate;
+	rect->rect.len = sc->len;
+	rect->confidence = *result;
+	return true;
+}
+
+void batch_image(size_t task, unsigned int worker, void *args)
+{
+	struct batch_args *a = args;
+	struct cas_detector *det = a->det[worker];
+	const struct cas_batch_image *im = &a->imgs[task];
+	struct cas_det_array *res = &a->res[task];
+	size_t n;
+
+	if (im->h <= 0 || im->w <= 0)
+		return;
+	if (!cas_detector_run(det, im->h, im->w, (const void *)im->img, NULL,
+			      0, NULL, 0, &n)) {
+		a->failed[worker] = true;
+		return;
+	}
+	if (n == 0)
+		return;
+	if ((res->rect = malloc(sizeof(struct cas_det_rect) * n)) == NULL) {
+		a->failed[worker] = true;
+		return;
+	}
+	memcpy(res->rect, det->det.rect, sizeof(struct cas_det_rect) * n);
+	res->size = n;
+}
+
+int det_cmp(const void *a, const void *b)
+{
+	const struct cas_rect *r1 = &((const struct cas_det_rect *)a)->rect;
+	const struct cas_rect *r2 = &((const struct cas_det_rect *)b)->rect;
+	if (r1->len != r2->len)
+		return (r1->len > r2->len) - (r1->len < r2->len);
+	if (r1->start_y != r2->start_y)
+		return (r1->start_y > r2->start_y) - (r1->start_y < r2->start_y);
+	return (r1->start_x > r2->start_x) - (r1->start_x < r2->start_x);
+}
+
+int conf_cmp(const void *a, const void *b)
+{
+	flt_t c1 = ((const struct cas_det_rect *)a)->confidence;
+	flt_t c2 = ((const struct cas_det_rect *)b)->confidence;
+	if (c1 != c2)
+		return (c1 < c2) - (c1 > c2);
+	return det_cmp(a, b);
+}
+
+bool merge(struct cas_detector *det)
+{
+	size_t n = 0;
+	unsigned int k;
+	for (k = 0; k < det->threads; ++k)
+		n += pack_array_size(&det->found[k]);
+	det->det.size = 0;
+	if (!RESERVE(det->det.rect, det->det_cap, n))
+		return false;
+
+	for (k = 0; k < det->threads; ++k)
+		for (unsigned int i = 0; i < pack_array_size(&det->found[k]); ++i)
+			det->det.rect[det->det.size++] = *(struct cas_det_rect *)
+			    pack_array_get(&det->found[k], i);
+	// 没有目标时 rect 可能为 NULL，不能传给 qsort()
+	if (det->det.size > 0)
+		qsort(det->det.rect, det->det.size,
+		      sizeof(struct cas_det_rect), conf_cmp);
+	return true;
+}
+
 bool ada_write(const void *adaboost, va_list ap, FILE * file)
 {
 	const struct haar_ada_handles *hl =
@@ -295,53 +1456,65 @@ void ada_free(void *adaboost, va_list ap)
 	hl->free(adaboost, &hl->wl_hl);
 }
 
-// 极大值抑制方法（NMS）处理重叠窗口
-void NMS(struct link_list *list, flt_t threshold)
+// 极大值抑制方法（NMS）处理重叠窗口：将各目标放入均匀网格（目标放入其覆盖的
+// 所有网格），每个保留的目标只与其覆盖网格中的目标比较
+bool NMS(struct cas_detector *det, flt_t threshold)
 {
-	flt_t iou;		// 窗口重叠度
-	struct cas_det_rect *rect1, *rect2;
-	struct cas_det_rect *rect_ptr = NULL;
-	flt_t max_val;
-	link_iter iter;
-	link_iter prev;
-	link_iter max_posi;	// 最大置信度窗口的前一节点
-	link_iter head;		// 未处理窗口的头节点
-	head = link_list_head_iter(list);
-	while (head->next != NULL) {
-		// 查找最大置信度边框
-		iter = head;
-		prev = head;
-		max_val = -DBL_MAX;
-		max_posi = NULL;
-		link_list_next_iter(&iter);
-		while (link_list_check_end(iter)) {
-			rect_ptr = link_list_get_data(iter);
-			if (rect_ptr->confidence > max_val) {
-				max_val = rect_ptr->confidence;
-				max_posi = prev;
-			}
-			prev = iter;
-			link_list_next_iter(&iter);
-		}
-		// 最大置信度窗口移动到头部
-		link_list_move(head, max_posi);
-		link_list_next_iter(&head);
-		// 删除重叠度大于给定阈值的窗口
-		iter = head;
-		prev = head;
-		link_list_next_iter(&iter);
-		while (link_list_check_end(iter)) {
-			rect1 = link_list_get_data(head);
-			rect2 = link_list_get_data(iter);
-			iou = IoU(&rect1->rect, &rect2->rect);
-			if (iou > threshold) {
-				link_list_next_iter(&iter);
-				rect_ptr = link_list_pop(list, prev);
-				free(rect_ptr);
-			} else {
-				prev = iter;
-				link_list_next_iter(&iter);
-			}
+	struct cas_det_rect *rect = det->det.rect;
+	size_t n = det->det.size;
+	size_t i, k;
+	if (n == 0)
+		return true;
+
+	// 网格边长取目标的平均边长
+	flt_t len_sum = 0;
+	imgsz_t right = 0, bottom = 0;
+	for (i = 0; i < n; ++i) {
+		len_sum += rect[i].rect.len;
+		right = MAX(right, rect[i].rect.start_x + rect[i].rect.len);
+		bottom = MAX(bottom, rect[i].rect.start_y + rect[i].rect.len);
+	}
+	imgsz_t cell = MAX((imgsz_t) (len_sum / n), 1);
+	imgsz_t cols = right / cell + 1;
+	size_t cells = (size_t) (bottom / cell + 1) * cols;
+
+	// 以压缩行存储的方式建立索引：网格 c 中的目标为 item[start[c]] ~
+	// item[start[c + 1] - 1]，按置信度从大到小排列
+	if (!RESERVE(det->start, det->start_cap, cells + 1)
+	    || !RESERVE(det->removed, det->removed_cap, n))
+		return false;
+	size_t *start = det->start;
+	bool *removed = det->removed;
+	memset(start, 0, sizeof(size_t) * (cells + 1));
+	memset(removed, 0, sizeof(bool) * n);
+	for (i = 0; i < n; ++i)
+		GRID_FOR_EACH(&rect[i].rect, cell, cols, c)
+		    ++start[c + 1];
+	for (size_t c = 0; c < cells; ++c)
+		start[c + 1] += start[c];
+	if (!RESERVE(det->item, det->item_cap, start[cells]))
+		return false;
+	size_t *item = det->item;
+	for (i = 0; i < n; ++i)
+		GRID_FOR_EACH(&rect[i].rect, cell, cols, c)
+		    item[start[c]++] = i;
+	for (size_t c = cells; c > 0; --c)
+		start[c] = start[c - 1];
+	start[0] = 0;
+
+	// 依次保留未被抑制的目标，并抑制邻近的、重叠度大于阈值的目标
+	for (i = 0, k = 0; i < n; ++i) {
+		if (removed[i])
+			continue;
+		GRID_FOR_EACH(&rect[i].rect, cell, cols, c)
+		    for (size_t p = start[c]; p < start[c + 1]; ++p) {
+			size_t j = item[p];
+			if (j > i && !removed[j]
+			    && IoU(&rect[i].rect, &rect[j].rect) > threshold)
+				removed[j] = true;
 		}
+		rect[k++] = rect[i];
 	}
+	det->det.size = k;
+	return true;
 }
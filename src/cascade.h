@@ -34,6 +34,73 @@ struct cascade {
 	flt_t det_ratio;	///< 检测率
 };
 
+/// 检测结果
+struct cas_det_array {
+	struct cas_det_rect *rect;	///< 目标数组，按置信度从大到小排列
+	size_t size;			///< 目标数量
+};
+
+/// 多尺度检测的方式
+enum cas_scan_mode {
+	CAS_SCAN_FEATURE,	///< 放大特征（及窗口移动距离），在原图像上检测
+	CAS_SCAN_PYRAMID,	///< 缩小图像（图像金字塔），各层均以训练尺度检测
+};
+
+/// 检测参数
+struct cas_det_param {
+	imgsz_t delta;		///< 窗口每次移动的像素数，将以 1.25 的倍数不断被放大
+	unsigned int threads;	///< 检测线程数；为 0 或 1 时在调用者线程中检测
+	enum cas_scan_mode mode;	///< 多尺度检测的方式
+	flt_t roi_margin;	///< 区域扫描时，区域向四周扩展的距离与区域边长之比
+	num_t roi_scales;	///< 区域扫描时，在区域边长上下各扫描的尺度数
+	bool adaptive;		///< 是否按窗口得分自适应地调整扫描步长
+	flt_t skip_score;	///< 自适应扫描：在第一个强学习器被拒绝且得分低于该
+				/**< 值（须为负数）的窗口之后，额外跳过得分与该值
+				 * 之比（取整）个窗口 */
+	imgsz_t skip_max;	///< 自适应扫描：一次最多额外跳过的窗口数（非负）
+	num_t dense_stage;	///< 自适应扫描：通过不少于该数量强学习器的窗口，
+				/**< 以 1 个像素的步长重新扫描其邻域 */
+};
+
+/// 检测器扫描窗口的统计信息（用于评估自适应扫描的召回率与速度）
+struct cas_scan_stat {
+	unsigned long grid;	///< 固定步长扫描所需检测的窗口数
+	unsigned long windows;	///< 实际检测的窗口数（含邻域重新扫描的窗口）
+	unsigned long skipped;	///< 因得分过低而跳过的网格窗口数
+	unsigned long dense;	///< 邻域重新扫描所检测的窗口数
+};
+
+/// 检测器（不透明类型）：持有按最大帧尺寸申请的缓冲区，用于逐帧检测视频流
+struct cas_detector;
+
+/// 批量检测的一幅图像
+struct cas_batch_image {
+	imgsz_t h;			///< 图像高度
+	imgsz_t w;			///< 图像宽度
+	const unsigned char *img;	///< 灰度图片（h × w，按行存放）
+};
+
+/// 编译后的 AdaBoost 强学习器（弱学习器存放于 struct cas_compiled 中）
+struct cas_stage {
+	num_t begin;		///< 第一个弱学习器的下标
+	num_t end;		///< 最后一个弱学习器的下一个下标
+	flt_t threshold;	///< 分类的阈值
+};
+
+/// 编译后的级联分类器：对应于给定的窗口边长及图像宽度，用于快速检测
+struct cas_compiled {
+	imgsz_t len;			///< 窗口边长，为 0 时表示尚未编译
+	imgsz_t wid;			///< 图像宽度
+	num_t stage_ct;			///< 强学习器数量
+	struct cas_stage *stage;	///< 强学习器数组
+	struct wl_haar_compiled *wl;	///< 所有强学习器的弱学习器（连续存放）
+	flt_t *trace;			///< 各弱学习器之后的拒绝阈值（软级联，
+					/**< 无拒绝阈值时为 -DBL_MAX）*/
+	ptrdiff_t corner[3];		///< 计算窗口标准差所用的积分图偏移
+					/**< （右上、左下、右下角）*/
+	imgsz_t area;			///< 计算窗口标准差所用的像素个数
+};
+
 /**
  * \brief 回调函数类型：获取图片及人脸矩形框。
  * 	每次执行，都将获取一张包含人脸的图片及表示人脸位置的矩形框，训练时将从
@@ -63,6 +130,14 @@ typedef const unsigned char *(*cas_face_fn) (imgsz_t * h, imgsz_t * w,
 typedef const unsigned char *(*cas_non_face_fn) (imgsz_t * h, imgsz_t * w,
 						 num_t * id, void *args);
 
+/**
+ * \brief 回调函数类型，接收挖掘扫描所接受的一个窗口
+ * \param[in] rect     被级联分类器接受的窗口（原图像坐标）
+ * \param[in, out] args 用户自定义的参数，用于保证可重入性
+ * \return 继续扫描则返回真；返回假时立即停止扫描（如样本已足够）
+ */
+typedef bool (*cas_mine_fn) (const struct cas_rect * rect, void *args);
+
 /*******************************************************************************
  * 				    函数声明
  ******************************************************************************/
@@ -79,7 +154,9 @@ typedef const unsigned char *(*cas_non_face_fn) (imgsz_t * h, imgsz_t * w,
  * \param[in] args         用户自定义参数
  * \param[in] get_face     回调函数，获取人脸样本，参数 args 将被传递给该函数；
  * \param[in] get_non_face 回调函数，获取非人脸图片，参数 args 将被传递给该函数
- * \param[in] hl           级联分类器回调函数集
+ * \param[in] hl           级联分类器回调函数集。hl->wl_hl.ctx 不为 NULL 时，
+ * 	训练（包括样本截取与挖掘）只使用该训练上下文中的随机数状态及参数，各级联
+ * 	分类器使用各自的上下文时可在同一进程中并行训练
  * \return 训练成功返回真，否则返回假
  * 	注：训练过程未出错，但无法达到指定假阳率的情形，仍返回真
  */
@@ -88,6 +165,28 @@ bool cas_train(struct cascade *cascade, flt_t d, flt_t f, flt_t F,
 	       void *args, cas_face_fn get_face, cas_non_face_fn get_non_face,
 	       struct haar_ada_handles *hl);
 
+/**
+ * \brief 可从检查点恢复的 cascade 分类器训练。
+ * 	每训练一个强学习器之前（包括开始训练时），将训练参数、已训练的强学习器、
+ * 	当前的样本集及随机数种子写入检查点文件（先写入临时文件再重命名，写入过程
+ * 	中断不会破坏原检查点）；随机数状态取自训练上下文，为 NULL 时取自默认
+ * 	上下文（见 train_ctx.h）。
+ * 	若检查点文件已存在，则从中恢复，跳过已训练的强学习器，且无需重新获取样本；
+ * 	训练参数与检查点不一致时返回假。
+ * 	注：get_face、get_non_face 及 hl 中的用户状态（如图片读取位置、进化算法
+ * 	的精英个体档案）以及已获取但尚未挖掘的非人脸图片不保存在检查点中，恢复后
+ * 	由调用者提供
+ * \param[in] ckpt 检查点文件路径
+ * \details 其余参数同 cas_train()
+ * \return 训练成功返回真，否则返回假。检查点文件总是保留（出错后可再次恢
+ * 	复），训练结束后由调用者删除
+ */
+bool cas_train_resume(struct cascade *cascade, const char *ckpt, flt_t d,
+		      flt_t f, flt_t F, flt_t train_pct, num_t face,
+		      num_t non_face, imgsz_t img_size, void *args,
+		      cas_face_fn get_face, cas_non_face_fn get_non_face,
+		      struct haar_ada_handles *hl);
+
 /**
  * \brief 保存级联分类器的模型参数到文件
  * \param[in] cascade 要保存参数的级联分类器
@@ -116,7 +215,7 @@ bool cas_read(struct cascade *cascade, FILE * file,
 void cas_free(struct cascade *cascade, const struct haar_ada_handles *hl);
 
 /**
- * \brief 计算两个矩形之间的重叠度
+ * \brief 计算两个矩形之间的重叠度（交并比）
  * \param[in] rect1 已初始化的矩形结构体
  * \param[in] rect2 已初始化的矩形结构体
  * \return 返回重叠度（0~1）
@@ -137,6 +236,44 @@ flt_t cas_h(const struct cascade *cascade, imgsz_t n, imgsz_t wid,
 	    const flt_t x[n][wid], const flt_t x2[n][wid],
 	    const struct haar_ada_handles *hl);
 
+/**
+ * \brief 初始化编译后的级联分类器（申请内存，尚未编译）
+ * \param[out] cc     未初始化的编译结果
+ * \param[in] cascade 已训练完毕或已从文件中读取参数的级联分类器
+ * \return 成功则返回真，否则返回假
+ */
+bool cas_compiled_init(struct cas_compiled *cc, const struct cascade *cascade);
+
+/**
+ * \brief 在给定窗口边长、图像宽度下编译级联分类器：特征被展开为积分图上的偏移
+ * 	量及权重，尺度归一化并入划分值，检测时无需再计算特征位置
+ * \param[in, out] cc 已初始化的编译结果（可重复编译）
+ * \param[in] cascade 初始化 cc 时所用的级联分类器
+ * \param[in] len     窗口边长
+ * \param[in] wid     图像的实际宽度
+ * \param[in] hl      Adaboost 相关回调函数集合
+ * \return 成功则返回真；弱学习器不支持编译时返回假
+ */
+bool cas_compile(struct cas_compiled *cc, const struct cascade *cascade,
+		 imgsz_t len, imgsz_t wid, const struct haar_ada_handles *hl);
+
+/**
+ * \brief 释放编译后的级联分类器
+ * \param[in] cc 已初始化的编译结果
+ */
+void cas_compiled_free(struct cas_compiled *cc);
+
+/**
+ * \brief 使用编译后的级联分类器获取分类结果，结果与 cas_h() 相同（仅在特征值
+ * 	恰好等于划分值时可能因舍入不同而有差异）
+ * \param[in] cc 已编译的级联分类器
+ * \param[in] x  窗口左上角在积分图中的地址（积分图宽度为 cc->wid）
+ * \param[in] x2 窗口左上角在灰度值平方的积分图中的地址
+ * \return 输出分类结果（置信度）
+ */
+flt_t cas_compiled_h(const struct cas_compiled *cc, const flt_t * x,
+		     const flt_t * x2);
+
 /**
  * \brief 多尺度、多位置扫描图像并返回下一目标所在的矩形框
  * \param[in] cascade   已训练的级联分类器
@@ -169,6 +306,150 @@ struct link_list cas_detect(const struct cascade *cascade, imgsz_t h,
 			    imgsz_t w, unsigned char img[h][w], imgsz_t delta,
 			    const struct haar_ada_handles *hl);
 
+/**
+ * \brief 释放检测结果
+ * \param[in] arr cas_detect_ex() 返回的检测结果
+ */
+void cas_det_array_free(struct cas_det_array *arr);
+
+/**
+ * \brief 初始化检测参数：窗口移动 1 个像素，单线程检测，放大特征；区域扫描时
+ * 	区域向四周扩展边长的 0.5 倍，并扫描区域边长上下各 1 个尺度；不使用自适
+ * 	应扫描（启用时：得分低于 -2 的窗口之后最多额外跳过 2 个窗口，通过 2 个
+ * 	强学习器的窗口重新扫描其邻域）
+ * \param[out] param 未初始化的检测参数
+ */
+void cas_det_param_default(struct cas_det_param *param);
+
+/**
+ * \brief 按检测参数扫描图像并返回检测到的所有目标（数组）。
+ * 	检测的窗口尺度与 cas_nextobj() 相同。图像金字塔方式下，各层图像按窗口尺
+ * 	度与训练尺度之比缩小（最近邻采样，同训练样本的采样方式），并在各层上以训
+ * 	练尺度检测，窗口移动距离按比例换算到各层（至少 1 个像素），所得目标换算
+ * 	回原图像坐标；其结果与放大特征的方式相近，但不完全相同。
+ * 	多线程检测时，各尺度的每一行窗口作为一个任务，由工作窃取线程池执行；各线
+ * 	程将目标保存到私有缓冲区，全部完成后合并，再进行极大值抑制，结果与单线程
+ * 	检测完全相同。
+ * 	自适应扫描时，窗口在第一个强学习器即被拒绝且得分低于 param->skip_score
+ * 	则额外跳过若干网格窗口；窗口通过 param->dense_stage 个强学习器时，以 1
+ * 	个像素的步长检测该窗口与相邻网格窗口之间（各方向一半距离内）的窗口，检
+ * 	测结果与固定步长扫描不同。
+ * 	极大值抑制：目标按置信度从大到小排序（置信度相同时按扫描顺序），依次保留
+ * 	未被抑制的目标，并抑制与之重叠度大于 0.1 的其余目标；借助均匀网格索引，
+ * 	每个目标只与邻近的目标比较
+ * \param[in] cascade 已训练的级联分类器
+ * \param[in] h       图像高度
+ * \param[in] w       图像宽度
+ * \param[in] img     已读入的灰度图片
+ * \param[in] param   检测参数
+ * \param[in] hl      Adaboost 相关回调函数集合
+ * \return 返回检测结果，需使用 cas_det_array_free() 释放；出错时返回空数组
+ */
+struct cas_det_array cas_detect_ex(const struct cascade *cascade, imgsz_t h,
+				   imgsz_t w, unsigned char img[h][w],
+				   const struct cas_det_param *param,
+				   const struct haar_ada_handles *hl);
+
+/**
+ * \brief 创建检测器：按最大帧尺寸申请积分图、图像金字塔、任务及结果缓冲区，
+ * 	预先编译各尺度下的级联分类器，并创建常驻线程池。
+ * 	积分图按最大帧宽度存放，因此较小的帧无需重新编译
+ * \param[in] cascade 已训练的级联分类器（检测器存续期间不得修改或释放）
+ * \param[in] max_h   最大帧高度
+ * \param[in] max_w   最大帧宽度
+ * \param[in] param   检测参数；自适应扫描时 skip_score 须为负数、skip_max
+ * 	须非负，否则视为参数错误
+ * \param[in] hl      Adaboost 相关回调函数集合
+ * \return 成功则返回检测器，否则返回 NULL
+ */
+struct cas_detector *cas_detector_new(const struct cascade *cascade,
+				      imgsz_t max_h, imgsz_t max_w,
+				      const struct cas_det_param *param,
+				      const struct haar_ada_handles *hl);
+
+/**
+ * \brief 释放检测器
+ * \param[in] det cas_detector_new() 创建的检测器，可以为 NULL
+ */
+void cas_detector_free(struct cas_detector *det);
+
+/**
+ * \brief 使用检测器检测一帧图像，目标写入调用者提供的数组。
+ * 	给定区域（通常为上一帧的检测结果）时，仅扫描各区域向四周扩展后的范围，
+ * 	且仅扫描区域边长上下 param->roi_scales 个尺度；所扫描的窗口是全图扫描
+ * 	窗口的子集。未给定区域时扫描整幅图像（上一帧无目标时即退化为全图扫描），
+ * 	调用者应每隔若干帧进行一次全图扫描，以发现新出现的目标。
+ * 	各缓冲区按需扩容后保留容量，因此稳定运行时不申请内存、不创建线程
+ * \param[in, out] det 检测器
+ * \param[in] h        图像高度（不大于最大帧高度）
+ * \param[in] w        图像宽度（不大于最大帧宽度）
+ * \param[in] img      已读入的灰度图片
+ * \param[in] roi      要扫描的区域，可以为 NULL
+ * \param[in] roi_ct   区域数量，为 0 时扫描整幅图像
+ * \param[out] out     用于保存目标的数组，目标按置信度从大到小排列
+ * \param[in] cap      out 的长度，超出的目标不写入
+ * \param[out] n       检测到的目标数量（可能大于 cap）
+ * \return 成功则返回真；图像超出最大帧尺寸或无法申请内存时返回假
+ */
+bool cas_detector_run(struct cas_detector *det, imgsz_t h, imgsz_t w,
+		      const unsigned char img[h][w],
+		      const struct cas_det_rect roi[], size_t roi_ct,
+		      struct cas_det_rect out[], size_t cap, size_t *n);
+
+/**
+ * \brief 获取检测器扫描窗口的统计信息（自上次重置以来各帧的累计值）。
+ * 	grid - windows 即自适应扫描相对于固定步长扫描所节省的窗口数（可能为负）
+ * \param[in] det   检测器
+ * \param[out] stat 用于保存统计信息
+ */
+void cas_detector_get_stat(const struct cas_detector *det,
+			   struct cas_scan_stat *stat);
+
+/**
+ * \brief 重置检测器扫描窗口的统计信息
+ * \param[in, out] det 检测器
+ */
+void cas_detector_reset_stat(struct cas_detector *det);
+
+/**
+ * \brief 使用检测器挖掘难负样本：按随机次序检测全图扫描的所有窗口（窗口集合
+ * 	与 cas_detector_run() 全图扫描相同），每个被接受的窗口立即交给回调函数，
+ * 	回调函数返回假时停止扫描。不进行极大值抑制，也不保存检测结果。
+ * 	随机次序：将所有窗口编号为 0 ~ N-1，从随机起点开始，以与 N 互素的随机步
+ * 	长遍历，因此每个窗口恰好检测一次，提前停止时所得窗口分布于整幅图像
+ * \param[in, out] det  检测器
+ * \param[in] h         图像高度（不大于最大帧高度）
+ * \param[in] w         图像宽度（不大于最大帧宽度）
+ * \param[in] img       已读入的灰度图片
+ * \param[in, out] rng  随机数状态（通常为由训练上下文派生的子上下文）
+ * \param[in] sink      回调函数，接收被接受的窗口
+ * \param[in, out] args 用户自定义参数，将被传递给 sink
+ * \return 成功则返回真；图像超出最大帧尺寸时返回假
+ */
+bool cas_detector_mine(struct cas_detector *det, imgsz_t h, imgsz_t w,
+		       const unsigned char img[h][w], struct train_ctx *rng,
+		       cas_mine_fn sink, void *args);
+
+/**
+ * \brief 批量检测多幅图像（尺寸可以不同）。
+ * 	各线程共用一个线程池，每个线程持有一个按最大图像尺寸创建的单线程检测器，
+ * 	以图像为任务并行检测（工作窃取）；各图像的结果与 cas_detect_ex() 单线程
+ * 	检测的结果完全相同
+ * \param[in] cascade 已训练的级联分类器
+ * \param[in] n       图像数量
+ * \param[in] imgs    各图像
+ * \param[in] param   检测参数，param->threads 为并行检测的图像数
+ * \param[in] hl      Adaboost 相关回调函数集合
+ * \param[out] res    长度为 n 的数组，用于保存各图像的检测结果，需逐个使用
+ * 	cas_det_array_free() 释放
+ * \return 成功则返回真；无法申请内存时返回假，此时 res 中均为空数组
+ */
+bool cas_detect_batch(const struct cascade *cascade, size_t n,
+		      const struct cas_batch_image imgs[],
+		      const struct cas_det_param *param,
+		      const struct haar_ada_handles *hl,
+		      struct cas_det_array res[]);
+
 /**
  * 一个训练级联分类器（人脸检测器）的例子。
  * \note
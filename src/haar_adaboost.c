@@ -16,13 +16,15 @@
  * 				  静态函数声明
  ******************************************************************************/
 /// struct ada_handles 的回调函数，初始化概率分布（正例样本总概率=负例样本总概率）
-static void init_D(flt_t D[], num_t m, const void *label);
+static void init_D(flt_t D[], num_t m, const void *label,
+		   const struct train_ctx *ctx);
 
 /// struct ada_handles 的回调函数，更新概率分布。
 /** 使用常规方法更新概率分布，并将中间值 vals 数组置为 alpha * h(X[i]), 
  * i = 0, 1, ..., vals_len - 1 */
 void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
-	      const void *label, flt_t alpha);
+	      const void *label, flt_t alpha,
+	      const struct train_ctx *ctx);
 
 /// struct ada_handles 的回调函数，计算检测率、假阳率，据此判断是否继续训练
 static bool wl_next(struct ada_item *item, void *adaboost,
@@ -38,9 +40,9 @@ bool haar_ada_approx_train(struct haar_adaboost *adaboost, flt_t * d,
 {
 	struct ada_handles ada_hl;
 	ada_hl_init(&ada_hl, l, m, haar_get_vals, alpha_approx, wl_next, init_D,
-		    update_D);
+		    update_D, handles->ctx);
 	return train_framework(adaboost, d, f, l, m, h, w, X, X2, Y,
-			       haar_all_pass, handles, &ada_hl);
+			       haar_all_pass, false, handles, &ada_hl);
 }
 
 bool haar_ada_newton_train(struct haar_adaboost *adaboost, flt_t * d,
@@ -50,9 +52,9 @@ bool haar_ada_newton_train(struct haar_adaboost *adaboost, flt_t * d,
 {
 	struct ada_handles ada_hl;
 	ada_hl_init(&ada_hl, l, m, haar_get_vals, alpha_newton, wl_next, init_D,
-		    update_D);
+		    update_D, handles->ctx);
 	return train_framework(adaboost, d, f, l, m, h, w, X, X2, Y,
-			       haar_all_pass_cf, handles, &ada_hl);
+			       haar_all_pass_cf, false, handles, &ada_hl);
 }
 
 flt_t haar_ada_h(const struct haar_adaboost *adaboost, imgsz_t h, imgsz_t w,
@@ -61,23 +63,59 @@ flt_t haar_ada_h(const struct haar_adaboost *adaboost, imgsz_t h, imgsz_t w,
 		 const struct wl_handles *handles)
 {
 	flt_t total = 0;
-	struct haar_wl *wl;
-	link_iter iter = link_list_start_iter(&adaboost->wl);
-	while (link_list_check_end(iter)) {
-		wl = link_list_get_data(iter);
+	const struct haar_wl *wl;
+	for (unsigned int i = 0; i < pack_array_size(&adaboost->wl); ++i) {
+		wl = pack_array_get(&adaboost->wl, i);
 		total += wl->alpha * handles->hypothesis.haar(wl->weaklearner,
 							      h, w, wid, x, x2,
 							      scale);
-		link_list_next_iter(&iter);
+		// 软级联：部分和低于拒绝阈值时提前拒绝
+		if (adaboost->trace != NULL && total < adaboost->trace[i])
+			return total - adaboost->trace[i];
 	}
 
 	return total - adaboost->threshold;
 }
 
+flt_t haar_ada_std_h(const struct haar_adaboost *adaboost, imgsz_t wid,
+		     const sample_t x[][wid], flt_t std_dev, flt_t scale,
+		     const struct wl_handles *handles)
+{
+	flt_t total = 0;
+	const struct haar_wl *wl;
+	for (unsigned int i = 0; i < pack_array_size(&adaboost->wl); ++i) {
+		wl = pack_array_get(&adaboost->wl, i);
+		total += wl->alpha * handles->hypothesis_std(wl->weaklearner,
+							     wid, x, std_dev,
+							     scale);
+		if (adaboost->trace != NULL && total < adaboost->trace[i])
+			return total - adaboost->trace[i];
+	}
+
+	return total - adaboost->threshold;
+}
+
+bool haar_ada_compile(struct wl_haar_compiled dst[],
+		      const struct haar_adaboost *adaboost, imgsz_t wid,
+		      flt_t scale, const struct wl_handles *handles)
+{
+	const struct haar_wl *wl;
+	if (handles->compile == NULL)
+		return false;
+	for (unsigned int i = 0; i < pack_array_size(&adaboost->wl); ++i) {
+		wl = pack_array_get(&adaboost->wl, i);
+		handles->compile(&dst[i], wl->weaklearner, wid, scale);
+		dst[i].output[0] *= wl->alpha;
+		dst[i].output[1] *= wl->alpha;
+	}
+	return true;
+}
+
 /*******************************************************************************
  * 				  静态函数定义
  ******************************************************************************/
-void init_D(flt_t D[], num_t m, const void *label)
+void init_D(flt_t D[], num_t m, const void *label,
+	    const struct train_ctx *ctx)
 {
 	num_t i;
 	num_t positive_ct = 0;
@@ -93,7 +131,8 @@ void init_D(flt_t D[], num_t m, const void *label)
 }
 
 void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
-	      const void *label, flt_t alpha)
+	      const void *label, flt_t alpha,
+	      const struct train_ctx *ctx)
 {
 	num_t i;
 	num_t start = vals_len - m;
@@ -118,7 +157,7 @@ bool wl_next(struct ada_item *item, void *adaboost, const flt_t vals[],
 {
 	flt_t det_rto, fal_pos_rto;
 	struct ada_wrap *ada = adaboost;
-	if (link_list_size(&ada->adaboost->wl) > 0) {
+	if (pack_array_size(&ada->adaboost->wl) > 0) {
 		get_ratio(&det_rto, &fal_pos_rto, adaboost, vals);
 #ifdef LOG
 		printf("Current AdaBoost false positive ratio: %f\n",
@@ -136,19 +175,13 @@ bool wl_next(struct ada_item *item, void *adaboost, const flt_t vals[],
 	printf("Create new weaklearner.\n");
 #endif
 	// 创建新的弱学习器，准备下一轮训练
-	struct haar_wl *wl = malloc(sizeof(struct haar_wl) + ada->wl_size);
-	if (wl == NULL)
-		goto malloc_err;
-	if (!link_list_append(&ada->adaboost->wl, wl))
-		goto link_list_err;
+	struct haar_wl *wl = pack_array_append(&ada->adaboost->wl);
+	if (wl == NULL) {
+		item->status = false;
+		return true;
+	}
 	item->alpha = &wl->alpha;
 	item->weaklearner = wl->weaklearner;
 	item->status = true;
 	return true;
-
-link_list_err:
-	free(wl);
-malloc_err:
-	item->status = false;
-	return true;
 }
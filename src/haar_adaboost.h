@@ -43,4 +43,20 @@ flt_t haar_ada_h(const struct haar_adaboost *adaboost, imgsz_t h, imgsz_t w,
 		 const sample_t x2[h][wid], flt_t scale,
 		 const struct wl_handles *handles);
 
+
+/**
+ * \brief 获取分类结果（给定窗口标准差），弱学习器系数不并入弱学习器
+ * \details \copydetails haar_ada_h_std_fn
+ */
+flt_t haar_ada_std_h(const struct haar_adaboost *adaboost, imgsz_t wid,
+		     const sample_t x[][wid], flt_t std_dev, flt_t scale,
+		     const struct wl_handles *handles);
+
+/**
+ * \brief 编译方法，弱学习器系数不并入弱学习器（输出值乘以系数 alpha）
+ * \details \copydetails haar_ada_compile_fn
+ */
+bool haar_ada_compile(struct wl_haar_compiled dst[],
+		      const struct haar_adaboost *adaboost, imgsz_t wid,
+		      flt_t scale, const struct wl_handles *handles);
 #endif
@@ -18,20 +18,24 @@
  * 				  静态函数声明
  ******************************************************************************/
 /// struct ada_handles 的回调函数，初始化概率分布（加入非对称损失）
-static void init_D(flt_t D[], num_t m, const void *label);
+static void init_D(flt_t D[], num_t m, const void *label,
+		   const struct train_ctx *ctx);
 
 /// 改进的概率分布初始化方法，避免非对称损失的效果迅速消失
-static void init_D_imp(flt_t D[], num_t m, const void *label);
+static void init_D_imp(flt_t D[], num_t m, const void *label,
+		       const struct train_ctx *ctx);
 
 /// struct ada_handles 的回调函数，使用常规方法更新概率分布
 /** 配合 init_D() 函数使用 */
 static void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
-		     const void *label, flt_t alpha);
+		     const void *label, flt_t alpha,
+		     const struct train_ctx *ctx);
 
 /// 改进的概率分布更新方法
 /** 配合 init_D_imp() 函数使用 */
 static void update_D_imp(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
-			 const void *label, flt_t alpha);
+			 const void *label, flt_t alpha,
+			 const struct train_ctx *ctx);
 
 /// struct ada_handles 的回调函数，计算检测率、假阳率，据此判断是否继续训练
 static bool wl_next(struct ada_item *item, void *adaboost, const flt_t vals[],
@@ -48,9 +52,9 @@ bool haar_ada_asym_train(struct haar_adaboost *adaboost, flt_t * d, flt_t * f,
 {
 	struct ada_handles ada_hl;
 	ada_hl_init(&ada_hl, l, m, haar_get_vals_cf, alpha_eq_1, wl_next,
-		    init_D, update_D);
+		    init_D, update_D, handles->ctx);
 	return train_framework(adaboost, d, f, l, m, h, w, X, X2, Y,
-			       haar_all_pass_cf, handles, &ada_hl);
+			       haar_all_pass_cf, true, handles, &ada_hl);
 }
 
 bool haar_ada_asym_imp_train(struct haar_adaboost *adaboost, flt_t * d,
@@ -61,9 +65,9 @@ bool haar_ada_asym_imp_train(struct haar_adaboost *adaboost, flt_t * d,
 {
 	struct ada_handles ada_hl;
 	ada_hl_init(&ada_hl, l, m, haar_get_vals_cf, alpha_eq_1, wl_next,
-		    init_D_imp, update_D_imp);
+		    init_D_imp, update_D_imp, handles->ctx);
 	return train_framework(adaboost, d, f, l, m, h, w, X, X2, Y,
-			       haar_all_pass_cf, handles, &ada_hl);
+			       haar_all_pass_cf, true, handles, &ada_hl);
 }
 
 flt_t haar_ada_fold_h(const struct haar_adaboost *adaboost, imgsz_t h,
@@ -72,26 +76,55 @@ flt_t haar_ada_fold_h(const struct haar_adaboost *adaboost, imgsz_t h,
 		      const struct wl_handles *handles)
 {
 	flt_t total = 0;
-	void *wl;
-	link_iter iter = link_list_start_iter(&adaboost->wl);
-	while (link_list_check_end(iter)) {
-		wl = link_list_get_data(iter);
+	const void *wl;
+	for (unsigned int i = 0; i < pack_array_size(&adaboost->wl); ++i) {
+		wl = pack_array_get(&adaboost->wl, i);
 		total +=
 		    handles->hypothesis.haar_cf(wl, h, w, wid, x, x2, scale);
-		link_list_next_iter(&iter);
+		// 软级联：部分和低于拒绝阈值时提前拒绝
+		if (adaboost->trace != NULL && total < adaboost->trace[i])
+			return total - adaboost->trace[i];
 	}
 
 	return total - adaboost->threshold;
 }
 
+flt_t haar_ada_fold_std_h(const struct haar_adaboost *adaboost, imgsz_t wid,
+			  const sample_t x[][wid], flt_t std_dev, flt_t scale,
+			  const struct wl_handles *handles)
+{
+	flt_t total = 0;
+	for (unsigned int i = 0; i < pack_array_size(&adaboost->wl); ++i) {
+		total += handles->hypothesis_std(pack_array_get(&adaboost->wl, i),
+						 wid, x, std_dev, scale);
+		if (adaboost->trace != NULL && total < adaboost->trace[i])
+			return total - adaboost->trace[i];
+	}
+
+	return total - adaboost->threshold;
+}
+
+bool haar_ada_fold_compile(struct wl_haar_compiled dst[],
+			   const struct haar_adaboost *adaboost, imgsz_t wid,
+			   flt_t scale, const struct wl_handles *handles)
+{
+	if (handles->compile == NULL)
+		return false;
+	for (unsigned int i = 0; i < pack_array_size(&adaboost->wl); ++i)
+		handles->compile(&dst[i], pack_array_get(&adaboost->wl, i),
+				 wid, scale);
+	return true;
+}
+
 /*******************************************************************************
  * 				  静态函数定义
  ******************************************************************************/
-void init_D(flt_t D[], num_t m, const void *label)
+void init_D(flt_t D[], num_t m, const void *label,
+	    const struct train_ctx *ctx)
 {
 	num_t i;
 	flt_t Z = 0;
-	const flt_t val_p = sqrt(ASYM_CONST);
+	const flt_t val_p = sqrt(train_asym_const(ctx));
 	const flt_t val_n = 1.0 / val_p;
 	const label_t *Y = label;
 	for (i = 0; i < m; ++i) {
@@ -103,11 +136,13 @@ void init_D(flt_t D[], num_t m, const void *label)
 		D[i] /= Z;
 }
 
-void init_D_imp(flt_t D[], num_t m, const void *label)
+void init_D_imp(flt_t D[], num_t m, const void *label,
+		const struct train_ctx *ctx)
 {
 	num_t i;
 	flt_t Z = 0;
-	const flt_t val_p = pow(ASYM_CONST, 1.0 / (2 * ASYM_TURN));
+	const flt_t val_p = pow(train_asym_const(ctx),
+				1.0 / (2 * train_asym_turn(ctx)));
 	const flt_t val_n = 1.0 / val_p;
 	const label_t *Y = label;
 	for (i = 0; i < m; ++i) {
@@ -120,7 +155,8 @@ void init_D_imp(flt_t D[], num_t m, const void *label)
 }
 
 void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
-	      const void *label, flt_t alpha)
+	      const void *label, flt_t alpha,
+	      const struct train_ctx *ctx)
 {
 	num_t i;
 	num_t start = vals_len - m;
@@ -138,13 +174,15 @@ void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
 }
 
 void update_D_imp(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
-		  const void *label, flt_t alpha)
+		  const void *label, flt_t alpha,
+		  const struct train_ctx *ctx)
 {
 	num_t i;
 	num_t start = vals_len - m;
 	flt_t Z = 0;
 	const label_t *Y = label;
-	const flt_t val_p = pow(ASYM_CONST, 1.0 / (2 * ASYM_TURN));
+	const flt_t val_p = pow(train_asym_const(ctx),
+				1.0 / (2 * train_asym_turn(ctx)));
 	const flt_t val_n = 1.0 / val_p;
 
 	// 更新训练集分布概率
@@ -161,10 +199,9 @@ void update_D_imp(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
 bool wl_next(struct ada_item *item, void *adaboost, const flt_t vals[],
 	     num_t vals_len)
 {
-	static flt_t alpha;
 	flt_t det_rto, fal_pos_rto;
 	struct ada_wrap *ada = adaboost;
-	if (link_list_size(&ada->adaboost->wl) > 0) {
+	if (pack_array_size(&ada->adaboost->wl) > 0) {
 		get_ratio(&det_rto, &fal_pos_rto, adaboost, vals);
 #ifdef LOG
 		printf("Current AdaBoost false positive ratio: %f\n",
@@ -182,19 +219,13 @@ bool wl_next(struct ada_item *item, void *adaboost, const flt_t vals[],
 	printf("Create new weaklearner.\n");
 #endif
 	// 创建新的弱学习器，准备下一轮训练
-	unsigned char *wl = malloc(ada->wl_size);
-	if (wl == NULL)
-		goto malloc_err;
-	if (!link_list_append(&ada->adaboost->wl, wl))
-		goto link_list_err;
+	unsigned char *wl = pack_array_append(&ada->adaboost->wl);
+	if (wl == NULL) {
+		item->status = false;
+		return true;
+	}
 	item->weaklearner = wl;
-	item->alpha = &alpha;
+	item->alpha = &ada->alpha;
 	item->status = true;
 	return true;
-
-link_list_err:
-	free(wl);
-malloc_err:
-	item->status = false;
-	return true;
 }
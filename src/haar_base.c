@@ -1,7 +1,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "haar_base.h"
-#include "link_list.h"
+#include "pack_array.h"
 /**
  * \file haar_base.c
  * \brief 基于哈尔特征的 Adaboost 分类器--函数实现
@@ -13,27 +13,44 @@
 /*******************************************************************************
  * 				   宏函数定义
  ******************************************************************************/
+/// 文件中标志字节的各位：系数 alpha 是否并入弱学习器
+#define HAAR_FLAG_FOLD 0x1
+/// 文件中标志字节的各位：是否保存有软级联的拒绝阈值
+#define HAAR_FLAG_TRACE 0x2
+
 /**
  * \brief 向文件写入或从文件读取 Adaboost
  * \param[in, out] ada    读取时，是未初始化的 Adaboost；写入时，需已初始化
+ * \param[in, out] flags  标志字节（unsigned char 型左值），由 HAAR_FLAG_*
+ * 			 组合而成；写入时需已设置
  * \param[in, out] file   已打开的文件
  * \param[in] hl          弱学习器回调函数集合，const struct wl_handles * 类型
  * \param[in] frw_fun     fread 或 fwrite
  * \param[in] wl_rw       wl_read 或 wl_write
- * \param[in] link_rw_fun link_list_read 或 link_list_write
+ * \param[in] arr_rw_fun  pack_array_read 或 pack_array_write
+ * \param[in] init        读取文件头后执行的语句（用于初始化数组）
+ * \param[in] init_trace  读写拒绝阈值前执行的语句（用于申请内存）
  * \return 成功返回真；否则返回假
  */
-#define HAAR_RW(ada, file, hl, frw_fun, wl_rw, link_rw_fun)			\
+#define HAAR_RW(ada, flags, file, hl, frw_fun, wl_rw, arr_rw_fun, init,	\
+		init_trace)							\
 ({										\
 	bool finished = false;							\
 	do {									\
-		if (frw_fun (&(ada)->using_fold, sizeof(bool), 1, file) < 1)	\
+		if (frw_fun (&(flags), sizeof(unsigned char), 1, file) < 1)	\
 			break;							\
 		if (frw_fun (&(ada)->threshold, sizeof(flt_t), 1, file) < 1)	\
 			break;							\
-		if (! link_rw_fun(&(ada)->wl, file, wl_rw,			\
+		init;								\
+		if (! arr_rw_fun(&(ada)->wl, file, wl_rw,			\
 					(int)(ada)->using_fold,	hl))		\
 				break;						\
+		size_t n = pack_array_size(&(ada)->wl);				\
+		if ((flags) & HAAR_FLAG_TRACE) {				\
+			init_trace;						\
+			if (frw_fun ((ada)->trace, sizeof(flt_t), n, file) < n)	\
+				break;						\
+		}								\
 		finished = true;						\
 	} while(0);								\
 	finished;								\
@@ -52,13 +69,14 @@
  ******************************************************************************/
 /**
  * \brief 从文件读取弱学习器
+ * \param[out] data:    数组元素地址，如使用弱学习器参数，则类型为
+ *      struct haar_wl *，其内包含弱学习器系数；否则为弱学习器地址
  * \param[in, out] ap: 可变参数列表，包含 int 参数（0或1，1 表示不使用弱学习器
  *      系数）以及 const struct wl_handles *（弱学习器回调函数）
  * \param[in] file:    保存弱学习器参数的文件
- * \return 成功则返回新创建的弱学习器地址，如使用弱学习器参数，则类型为
- *      struct haar_wl *，其内包含弱学习器系数；否则仅返回弱学习器地址
+ * \return 成功则返回真，否则返回假
  */
-void *wl_read(va_list ap, FILE * file);
+bool wl_read(void *data, va_list ap, FILE * file);
 
 /**
  * \brief 向文件写入弱学习器参数
@@ -70,11 +88,12 @@ bool wl_write(const void *data, va_list ap, FILE * file);
 
 /**
  * \brief 复制弱学习器
- * \param[out] data 弱学习器地址
- * \param[in] ap    同 wl_read
- * \return 成功则返回弱学习器 data 的一份拷贝，否则返回 NULL
+ * \param[out] dst 数组元素地址，用于保存 data 的一份拷贝
+ * \param[in] data 弱学习器地址
+ * \param[in] ap   同 wl_read
+ * \return 成功则返回真，否则返回假
  */
-void *wl_copy(const void *data, va_list ap);
+bool wl_copy(void *dst, const void *data, va_list ap);
 
 /**
  * \brief 释放弱学习器内部使用的内存，但不包括 data 本身
@@ -90,8 +109,18 @@ void wl_free(void *data, va_list ap);
 bool haar_ada_read(struct haar_adaboost *adaboost, FILE * file,
 		   const struct wl_handles *handles)
 {
-	link_list_init(&adaboost->wl);
-	if (!HAAR_RW(adaboost, file, handles, fread, wl_read, link_list_read)) {
+	unsigned char flags;
+	adaboost->trace = NULL;
+	pack_array_init(&adaboost->wl, 0);
+	if (!HAAR_RW(adaboost, flags, file, handles, fread, wl_read,
+		     pack_array_read,
+		     adaboost->using_fold = flags & HAAR_FLAG_FOLD;
+		     pack_array_init(&adaboost->wl,
+				     haar_wl_size(adaboost->using_fold,
+						  handles)),
+		     if ((adaboost->trace = malloc(sizeof(flt_t) * n)) == NULL
+			 && n > 0)
+		     break)) {
 		haar_ada_free(adaboost, handles);
 		return false;
 	}
@@ -101,23 +130,34 @@ bool haar_ada_read(struct haar_adaboost *adaboost, FILE * file,
 bool haar_ada_write(const struct haar_adaboost *adaboost, FILE * file,
 		    const struct wl_handles *handles)
 {
-	return HAAR_RW(adaboost, file, handles, fwrite, wl_write,
-		       link_list_write);
+	unsigned char flags = (adaboost->using_fold ? HAAR_FLAG_FOLD : 0)
+	    | (adaboost->trace != NULL ? HAAR_FLAG_TRACE : 0);
+	return HAAR_RW(adaboost, flags, file, handles, fwrite, wl_write,
+		       pack_array_write, (void)0, (void)0);
 }
 
 void *haar_ada_copy(struct haar_adaboost *dst,
 		    const struct haar_adaboost *src,
 		    const struct wl_handles *handles)
 {
+	size_t n = pack_array_size(&src->wl);
 	dst->using_fold = src->using_fold;
 	dst->threshold = src->threshold;
-	link_list_init(&dst->wl);
-	if (!link_list_copy_full(&dst->wl, &src->wl, wl_copy,
-				 (int)dst->using_fold, handles)) {
-		haar_ada_free(dst, handles);
-		return NULL;
+	dst->trace = NULL;
+	pack_array_init(&dst->wl, haar_wl_size(dst->using_fold, handles));
+	if (!pack_array_copy_full(&dst->wl, &src->wl, wl_copy,
+				 (int)dst->using_fold, handles))
+		goto err;
+	if (src->trace != NULL) {
+		if ((dst->trace = malloc(sizeof(flt_t) * n)) == NULL && n > 0)
+			goto err;
+		memcpy(dst->trace, src->trace, sizeof(flt_t) * n);
 	}
 	return dst;
+
+err:
+	haar_ada_free(dst, handles);
+	return NULL;
 }
 
 void haar_ada_free(struct haar_adaboost *adaboost,
@@ -125,43 +165,36 @@ void haar_ada_free(struct haar_adaboost *adaboost,
 {
 	if (handles->free != NULL) {
 		if (adaboost->using_fold)
-			link_list_traverse(&adaboost->wl, handles->free);
+			pack_array_traverse(&adaboost->wl, handles->free);
 		else
-			link_list_traverse_r(&adaboost->wl, wl_free, handles);
+			pack_array_traverse_r(&adaboost->wl, wl_free, handles);
 	}
-	link_list_free_full(&adaboost->wl, free);
+	pack_array_free_full(&adaboost->wl, NULL);
+	free(adaboost->trace);
+	adaboost->trace = NULL;
 }
 
 /*******************************************************************************
  * 				  静态函数定义
  ******************************************************************************/
-void *wl_read(va_list ap, FILE * file)
+bool wl_read(void *data, va_list ap, FILE * file)
 {
 	int using_fold = va_arg(ap, int);
 	const struct wl_handles *hl = va_arg(ap, const struct wl_handles *);
-	size_t size = hl->size;
-	if (!using_fold)
-		size += sizeof(struct haar_wl);
-	void *data = malloc(size);
-	if (data == NULL)
-		return NULL;
 
 	void *wl = data;
 	if (!using_fold) {	// 读取 alpha 系数
 		wl = HAAR_PTR(data, weaklearner);
 		if (fread(HAAR_PTR(data, alpha), sizeof(flt_t), 1, file) < 1)
-			goto err;
+			return false;
 	}
 	if (hl->read == NULL) {	// 读取弱学习器
 		if (fread(wl, hl->size, 1, file) < 1)
-			goto err;
+			return false;
 	} else if (!hl->read(wl, file))
-		goto err;
+		return false;
 
-	return data;
-err:
-	free(data);
-	return NULL;
+	return true;
 }
 
 bool wl_write(const void *data, va_list ap, FILE * file)
@@ -184,16 +217,10 @@ bool wl_write(const void *data, va_list ap, FILE * file)
 	return true;
 }
 
-void *wl_copy(const void *data, va_list ap)
+bool wl_copy(void *dst, const void *data, va_list ap)
 {
 	int using_fold = va_arg(ap, int);
 	const struct wl_handles *hl = va_arg(ap, const struct wl_handles *);
-	size_t size = hl->size;
-	if (!using_fold)
-		size += sizeof(struct haar_wl);
-	void *dst = malloc(size);
-	if (dst == NULL)
-		return NULL;
 
 	void *wl_dst = dst;
 	const void *wl_src = data;
@@ -204,12 +231,10 @@ void *wl_copy(const void *data, va_list ap)
 	}
 	if (hl->copy == NULL)	// 复制弱学习器
 		memcpy(wl_dst, wl_src, hl->size);
-	else if (!hl->copy(wl_dst, wl_src)) {
-		free(dst);
-		return NULL;
-	}
+	else if (!hl->copy(wl_dst, wl_src))
+		return false;
 
-	return dst;
+	return true;
 }
 
 void wl_free(void *data, va_list ap)
@@ -1,6 +1,6 @@
 #ifndef HAAR_BASE_H
 #define HAAR_BASE_H
-#include "link_list.h"
+#include "pack_array.h"
 #include "boost_cfg.h"
 #include "adaboost_base.h"
 #include "WeakLearner/weaklearner.h"
@@ -22,12 +22,15 @@ struct haar_wl {
 };
 
 /// 采用哈尔特征的 Adaboost 强学习器
-/** 注：如果 using_fold 为真，则链表 wl 中保存弱学习器的地址；
- * 如果 using_fold 为假，则链表 wl 中保存 struct haar_wl */
+/** 注：如果 using_fold 为真，则数组 wl 的元素为弱学习器；
+ * 如果 using_fold 为假，则数组 wl 的元素为 struct haar_wl。
+ * trace 非空时（软级联），累加完第 i 个弱学习器后，若部分和小于 trace[i]，
+ * 即可提前拒绝该样本 */
 struct haar_adaboost {
 	bool using_fold;		///< 系数 alpha 是否并入弱学习器的标志
-	struct link_list wl;		///< 弱学习器链表
+	struct pack_array wl;		///< 弱学习器数组（连续存放）
 	flt_t threshold;		///< 分类的阈值
+	flt_t *trace;			///< 各弱学习器之后的拒绝阈值，可以为 NULL
 };
 
 /*******************************************************************************
@@ -62,4 +65,20 @@ void *haar_ada_copy(struct haar_adaboost *dst,
 void haar_ada_free(struct haar_adaboost *adaboost,
 		   const struct wl_handles *handles);
 
+/*******************************************************************************
+ * 				  内联函数定义
+ ******************************************************************************/
+/**
+ * \brief 获取弱学习器数组单个元素的长度
+ * \param[in] using_fold 系数 alpha 是否并入弱学习器
+ * \param[in] handles    弱学习器回调函数集合
+ * \return 返回元素长度（字节）
+ */
+static inline size_t haar_wl_size(bool using_fold,
+				  const struct wl_handles *handles)
+{
+	return using_fold ? handles->size : sizeof(struct haar_wl) +
+	    handles->size;
+}
+
 #endif
@@ -23,8 +23,13 @@ typedef void (*output_fn)(flt_t *, num_t, const void *, const struct sp_wrap *);
 static bool wl_train(void *weaklearner, num_t m, const void *sample,
 		     const void *label, const flt_t D[]);
 
-/// 用于 qsort 比较（struct sort_item * 指针比较）
-static int sort_cmp(const void *item1, const void *item2);
+/**
+ * \brief 部分选择：返回数组中第 k 大的元素（数组元素顺序被打乱）
+ * \param[in, out] a 数组
+ * \param[in] n      数组长度
+ * \param[in] k      1 <= k <= n
+ */
+static flt_t select_kth(flt_t a[], num_t n, num_t k);
 
 /// 将样本集在弱学习器 wl 上的输出保存到 vals 数组中（输出值不带置信度）
 static void wl_output(flt_t vals[], num_t vals_len, const void *wl,
@@ -70,7 +75,8 @@ enum ada_result haar_get_vals_cf(flt_t vals[], num_t vals_len,
 
 void ada_hl_init(struct ada_handles *ada_hl, num_t l, num_t m,
 		 ada_vals_fn get_vals, ada_alpha_fn get_alpha, ada_next_fn next,
-		 ada_init_D_fn init_D, ada_update_D_fn update_D)
+		 ada_init_D_fn init_D, ada_update_D_fn update_D,
+		 const struct train_ctx *ctx)
 {
 	ada_hl->D_len = m;
 	ada_hl->vals_len = l + m;
@@ -80,6 +86,7 @@ void ada_hl_init(struct ada_handles *ada_hl, num_t l, num_t m,
 	ada_hl->next = next;
 	ada_hl->init_D = init_D;
 	ada_hl->update_D = update_D;
+	ada_hl->ctx = ctx;
 }
 
 bool init_setting(struct train_setting *st, struct haar_adaboost *adaboost,
@@ -95,112 +102,139 @@ bool init_setting(struct train_setting *st, struct haar_adaboost *adaboost,
 	st->sp.handles = wl_hl;
 
 	st->ada.adaboost = adaboost;
-	if ((st->ada.output = malloc(sizeof(struct sort_item) * l)) == NULL)
-		return false;
-	if ((st->ada.op_ptrs = malloc(sizeof(struct sort_item *) * l)) == NULL) {
-		free(st->ada.output);
-		return false;
-	}
 	st->ada.positive_ct = 0;
-	for (num_t i = 0; i < l; ++i) {
-		st->ada.output[i].id = i;
-		st->ada.output[i].val = 0;
-		st->ada.op_ptrs[i] = &st->ada.output[i];
+	for (num_t i = 0; i < l; ++i)
 		if (Y[i] > 0)
 			++st->ada.positive_ct;
+	if ((st->ada.output = calloc(l, sizeof(flt_t))) == NULL)
+		return false;
+	st->ada.pos_vals = malloc(sizeof(flt_t) * st->ada.positive_ct);
+	if (st->ada.pos_vals == NULL && st->ada.positive_ct > 0) {
+		free(st->ada.output);
+		return false;
 	}
 	st->ada.l = l;
 	st->ada.d = d;
 	st->ada.f = f;
 	st->ada.Y = Y;
-	st->ada.wl_size = wl_hl->size;
+	st->ada.alpha = 1;
+	st->ada.ctx = wl_hl->ctx;
 	return true;
 }
 
 void free_setting(struct train_setting *st)
 {
 	free(st->ada.output);
-	free(st->ada.op_ptrs);
+	free(st->ada.pos_vals);
 }
 
 void get_ratio(flt_t * d, flt_t * f, struct ada_wrap *ada, const flt_t vals[])
-/*
 {
 	num_t i;
-	num_t false_n = 0;		// 假阴性样本数量
-	num_t max_f_n;			// 所允许的最大假阴性样本数量
-	max_f_n = ada->positive_ct * (1 - ada->d);
-
-	// 计算当前分类结果（vals数组表示 alpha * h(X[i])）
-	for (num_t i = 0; i < ada->l; ++i)
-		ada->output[i].val += vals[i];
-	// 寻找满足刚好达到最大假阴性样本数量的数组位置（即 i-1 到 i 之间）
-	qsort (ada->op_ptrs, ada->l, sizeof(struct sort_item *), sort_cmp);
-	for (i = 0; i < ada->l; ++i)
-		if (ada->Y[ada->op_ptrs[i]->id] > 0 && ++false_n > max_f_n)
-			break;
-
-	// 最大假阴性，意味着刚好达到最小检测率，在此位置设置正、负例样本阈值
-	if (i == 0)
-		ada->adaboost->threshold = ada->op_ptrs[0]->val - MIN_INTERVAL;
-	else if (i < ada->l)
-		ada->adaboost->threshold = (ada->op_ptrs[i]->val +
-					    ada->op_ptrs[i-1]->val) / 2;
+	num_t n = 0;		// 已收集的正例数量
+	flt_t v;		// 阈值右侧（输出值不小于阈值）的最小输出值
+
+	// 计算当前分类结果（vals数组表示 alpha * h(X[i])），并收集正例分类结果
+	for (i = 0; i < ada->l; ++i) {
+		ada->output[i] += vals[i];
+		if (ada->Y[i] > 0)
+			ada->pos_vals[n++] = ada->output[i];
+	}
+	// 刚好满足检测率时，阈值右侧最小的输出值为第 min_det 大的正例输出值
+	if (n > 0) {
+		num_t min_det = ceil(n * ada->d);	// 真阳性样本最少数量
+		if (min_det < 1)
+			min_det = 1;
+		else if (min_det > n)
+			min_det = n;
+		v = select_kth(ada->pos_vals, n, min_det);
+	} else {
+		v = ada->output[0];
+		for (i = 1; i < ada->l; ++i)
+			if (ada->output[i] < v)
+				v = ada->output[i];
+	}
+
+	// 统计阈值右侧的正、负例数量，及阈值左侧的最大输出值
+	num_t det_ct = 0;	// 真阳性样本数量
+	num_t fp_ct = 0;	// 假阳性样本数量
+	bool has_left = false;	// 阈值左侧是否有样本
+	flt_t left = v;		// 阈值左侧的最大输出值
+	for (i = 0; i < ada->l; ++i) {
+		if (ada->output[i] >= v) {
+			if (ada->Y[i] > 0)
+				++det_ct;
+			else
+				++fp_ct;
+		} else if (!has_left || ada->output[i] > left) {
+			left = ada->output[i];
+			has_left = true;
+		}
+	}
+	// 用作属性划分，阈值取左右两侧输出值的中点
+	if (has_left)
+		ada->adaboost->threshold = (v + left) / 2;
 	else
-		ada->adaboost->threshold = ada->op_ptrs[ada->l-1]->val
-					   + MIN_INTERVAL;
+		ada->adaboost->threshold = v - train_min_interval(ada->ctx);
 
 	// 检测率、假阳率计算
 	if (ada->positive_ct > 0)
-		*d = (flt_t)(ada->positive_ct + 1 - false_n)
-			  / ada->positive_ct;
+		*d = (flt_t) det_ct / ada->positive_ct;
 	else
 		*d = 1;
 	if (ada->l > ada->positive_ct)
-		*f = (flt_t)(ada->l + false_n + 1 - i
-			       -ada->positive_ct) / (ada->l - ada->positive_ct);
+		*f = (flt_t) fp_ct / (ada->l - ada->positive_ct);
 	else
 		*f = 0;
-
 }
-*/
+
+bool set_trace(struct train_setting *st)
 {
-	num_t i;
-	num_t det_ct = 0;	// 真阳性样本数量
-	num_t min_det;		// 真阳性样本最少数量
-	min_det = ceil(ada->positive_ct * ada->d);
-
-	// 计算当前分类结果（vals数组表示 alpha * h(X[i])）
-	for (i = 0; i < ada->l; ++i)
-		ada->output[i].val += vals[i];
-	// 寻找刚好满足检测率的位置（即 i-1 到 i 之间）
-	qsort(ada->op_ptrs, ada->l, sizeof(struct sort_item *), sort_cmp);
-	for (i = ada->l - 1; i > 0; --i)
-		if (ada->Y[ada->op_ptrs[i]->id] > 0 && ++det_ct >= min_det)
-			break;
-	if (i == 0 && ada->Y[ada->op_ptrs[i]->id] > 0)
-		++det_ct;
-	// 用作属性划分，i-1 与 i 处的输出值必须不同
-	while (i > 0 && ada->op_ptrs[i]->val == ada->op_ptrs[i - 1]->val)
-		if (ada->Y[ada->op_ptrs[--i]->id] > 0)
-			++det_ct;
-	// 在此位置设置正、负例样本阈值
-	if (i > 0)
-		ada->adaboost->threshold = (ada->op_ptrs[i]->val +
-					    ada->op_ptrs[i - 1]->val) / 2;
-	else			// i == 0 的情形
-		ada->adaboost->threshold = ada->op_ptrs[0]->val - MIN_INTERVAL;
+	struct haar_adaboost *ada = st->ada.adaboost;
+	const struct sp_wrap *sp = &st->sp;
+	const struct wl_handles *hl = sp->handles;
+	unsigned int n = pack_array_size(&ada->wl);
+	flt_t partial[n];
+	bool found = false;
+
+	if (n == 0)
+		return true;
+	if ((ada->trace = malloc(sizeof(flt_t) * n)) == NULL)
+		return false;
+	for (num_t i = 0; i < sp->l; ++i) {
+		train_stream(hl->ctx, i, sp->X[i]);
+		if (st->ada.Y[i] <= 0)
+			continue;
+		// 累加顺序与 haar_ada_h()、haar_ada_fold_h() 相同
+		const void *x = sp->X[i], *x2 = sp->X2[i];
+		flt_t total = 0;
+		for (unsigned int t = 0; t < n; ++t) {
+			const void *wl = pack_array_get(&ada->wl, t);
+			if (ada->using_fold)
+				total += hl->hypothesis.haar_cf(wl, sp->h, sp->w,
+								sp->w, x, x2, 1);
+			else
+				total += ((const struct haar_wl *)wl)->alpha *
+				    hl->hypothesis.haar(((const struct haar_wl *)
+							 wl)->weaklearner,
+							sp->h, sp->w, sp->w, x,
+							x2, 1);
+			partial[t] = total;
+		}
+		// 仅考虑通过该 Adaboost 的正例
+		if (total - ada->threshold < 0)
+			continue;
+		for (unsigned int t = 0; t < n; ++t)
+			if (!found || partial[t] < ada->trace[t])
+				ada->trace[t] = partial[t];
+		found = true;
+	}
 
-	// 检测率、假阳率计算
-	if (ada->positive_ct > 0)
-		*d = (flt_t) det_ct / ada->positive_ct;
-	else
-		*d = 1;
-	if (ada->l > ada->positive_ct)
-		*f = (flt_t) (ada->l - i - det_ct) / (ada->l -
-						      ada->positive_ct);
-	else
-		*f = 0;
+	if (!found) {
+		free(ada->trace);
+		ada->trace = NULL;
+	}
+	return true;
 }
 
 bool haar_all_pass (struct train_setting *st)
@@ -221,51 +255,83 @@ bool wl_train(void *weaklearner, num_t m, const void *sample,
 {
 	const struct sp_wrap *sp = sample;
 	return sp->handles->train.haar(weaklearner, m, sp->h, sp->w,
-				       sp->X + sp->l, sp->X2 + sp->l, label, D);
+				       sp->X + sp->l, sp->X2 + sp->l, label, D,
+				       sp->handles->param, sp->handles->ctx);
 }
 
-int sort_cmp(const void *item1, const void *item2)
+flt_t select_kth(flt_t a[], num_t n, num_t k)
 {
-	flt_t result = (*(struct sort_item **)item1)->val -
-	    (*(struct sort_item **)item2)->val;
-	if (result < 0)
-		return -1;
-	else if (result > 0)
-		return 1;
-	else
-		return 0;
+	num_t lo = 0, hi = n - 1;
+	num_t target = k - 1;	// 按降序排列时的位置
+	flt_t pivot, tmp;
+	while (true) {
+		// 三数取中作为枢轴
+		flt_t x = a[lo], y = a[lo + (hi - lo) / 2], z = a[hi];
+		if ((x >= y) == (y >= z))
+			pivot = y;
+		else if ((y >= x) == (x >= z))
+			pivot = x;
+		else
+			pivot = z;
+
+		// 三路划分：a[lo..lt) > pivot，a[lt..gt) == pivot，a[gt..hi] < pivot
+		num_t lt = lo, gt = hi + 1;
+		for (num_t i = lo; i < gt;) {
+			if (a[i] > pivot) {
+				tmp = a[i], a[i] = a[lt], a[lt] = tmp;
+				++lt, ++i;
+			} else if (a[i] < pivot) {
+				--gt;
+				tmp = a[i], a[i] = a[gt], a[gt] = tmp;
+			} else {
+				++i;
+			}
+		}
+		if (target < lt)
+			hi = lt - 1;
+		else if (target >= gt)
+			lo = gt;
+		else
+			return pivot;
+	}
 }
 
 void wl_output(flt_t vals[], num_t vals_len, const void *wl,
 	       const struct sp_wrap *sp)
 {
-	for (num_t i = 0; i < vals_len; ++i)
+	for (num_t i = 0; i < vals_len; ++i) {
+		train_stream(sp->handles->ctx, i, sp->X[i]);
 		vals[i] =
 		    sp->handles->hypothesis.haar(wl, sp->h, sp->w, sp->w,
 						 (void *)sp->X[i],
 						 (void *)sp->X2[i], 1);
+	}
 }
 
 void wl_output_cf(flt_t vals[], num_t vals_len, const void *wl,
 		  const struct sp_wrap *sp)
 {
-	for (num_t i = 0; i < vals_len; ++i)
+	for (num_t i = 0; i < vals_len; ++i) {
+		train_stream(sp->handles->ctx, i, sp->X[i]);
 		vals[i] =
 		    sp->handles->hypothesis.haar_cf(wl, sp->h, sp->w, sp->w,
 						    (void *)sp->X[i],
 						    (void *)sp->X2[i], 1);
+	}
 }
 
 void wl_alpha(flt_t vals[], num_t vals_len, const void *weaklearner,
 	      const struct sp_wrap *sp)
 {
 	const struct haar_wl *wl = weaklearner;
-	for (num_t i = 0; i < vals_len; ++i)
+	for (num_t i = 0; i < vals_len; ++i) {
+		train_stream(sp->handles->ctx, i, sp->X[i]);
 		vals[i] =
 		    sp->handles->hypothesis.haar(wl->weaklearner, sp->h, sp->w,
 						 sp->w, (void *)sp->X[i],
 						 (void *)sp->X2[i],
 						 1) * wl->alpha;
+	}
 }
 
 enum ada_result get_vals_framework(flt_t vals[], num_t vals_len,
@@ -298,7 +364,7 @@ bool all_pass_framework (struct train_setting *st, output_fn op)
 	flt_t * vals = malloc (sizeof(flt_t) * st->ada.l);
 	if (vals == NULL)
 		return false;
-	op(vals, st->ada.l, st->ada.adaboost->wl.end_ptr->data, &st->sp);
+	op(vals, st->ada.l, pack_array_back(&st->ada.adaboost->wl), &st->sp);
 	get_ratio (&(st->ada.d), &(st->ada.f), &st->ada, vals);         
 	free (vals);
 	return true;
@@ -12,23 +12,20 @@
 /*******************************************************************************
  * 				    类型定义
  ******************************************************************************/
-/// 保存数组元素值及其索引，用于排序
-struct sort_item {
-	num_t id;		///< 元素索引
-	flt_t val;		///< 元素值
-};
-
 /// Adaboost 包装，附加某些必要变量
 struct ada_wrap {
 	struct haar_adaboost *adaboost;	///< Adaboost 学习器
-	struct sort_item *output;	///< 验证集分类结果
-	struct sort_item **op_ptrs;	///< output 的指针数组排序结果
+	flt_t *output;			///< 验证集分类结果
+	flt_t *pos_vals;		///< 验证集正例分类结果（get_ratio() 的临时
+					/**< 空间，元素顺序被打乱）*/
 	num_t positive_ct;		///< 验证集正例数量
 	num_t l;			///< 验证集样本数量
 	flt_t d;			///< Adaboost 最小检测率
 	flt_t f;			///< Adaboost 最大假阳率
 	const label_t *Y;		///< 验证集样本标签
-	size_t wl_size;			///< 弱学习器长度（字节）
+	flt_t alpha;			///< 弱学习器系数的存放位置（系数并入弱学
+					/**< 习器时使用）*/
+	const struct train_ctx *ctx;	///< 训练上下文，可为 NULL
 };
 
 /// 训练集结构体包装，包含额外的参数
@@ -88,10 +85,12 @@ enum ada_result haar_get_vals_cf(flt_t vals[], num_t vals_len,
  * \param[in] init_D    回调函数，初始化概率分布
  * \param[in] update_D  回调函数，更新概率分布，同时将 vals 数组置为
  *                      alpha * h(X[i])
+ * \param[in] ctx       训练上下文（如 wl_handles 的 ctx 字段），可为 NULL
  */
 void ada_hl_init(struct ada_handles *ada_hl, num_t l, num_t m,
 		 ada_vals_fn get_vals, ada_alpha_fn get_alpha, ada_next_fn next,
-		 ada_init_D_fn init_D, ada_update_D_fn update_D);
+		 ada_init_D_fn init_D, ada_update_D_fn update_D,
+		 const struct train_ctx *ctx);
 
 /**
  * \brief 训练的初始化操作
@@ -120,7 +119,8 @@ bool init_setting(struct train_setting *st, struct haar_adaboost *adaboost,
 void free_setting(struct train_setting *st);
 
 /**
- * \brief 计算当前检测率、假阳率
+ * \brief 计算当前检测率、假阳率，并设置刚好满足最小检测率的阈值
+ *      （以部分选择代替排序，时间复杂度为 O(l)）
  * \param[out] d   用于保存检测率
  * \param[out] f   用于保存假阳率
  * \param[out] ada Adaboost 包装结构体，output 字段将被更新
@@ -128,6 +128,16 @@ void free_setting(struct train_setting *st);
  */
 void get_ratio(flt_t * d, flt_t * f, struct ada_wrap *ada, const flt_t vals[]);
 
+/**
+ * \brief 计算软级联的拒绝阈值：在验证集中通过该 Adaboost 的正例上，计算累加完
+ *      每个弱学习器后的部分和，取其最小值作为该位置的拒绝阈值。检测时部分和
+ *      低于拒绝阈值即可提前拒绝，而这些正例均不会被提前拒绝
+ * \param[in, out] st 训练完毕的训练设置集，st->ada.adaboost->trace 将被设置（验
+ *      证集中没有通过的正例时为 NULL）
+ * \return 成功返回真，无法申请内存时返回假
+ */
+bool set_trace(struct train_setting *st);
+
 /**
  * \brief 当全部训练样本分类成功时执行的函数
  *      更新验证集的假阳率、检测率（不带置信度）
@@ -148,18 +158,23 @@ bool haar_all_pass_cf (struct train_setting *st);
  ******************************************************************************/
 /**
  * \brief 初始化 Adaboost
- * \param[out] ada 指向未初始化的 struct haar_adaboost 结构体
+ * \param[out] ada       指向未初始化的 struct haar_adaboost 结构体
+ * \param[in] using_fold 系数 alpha 是否并入弱学习器
+ * \param[in] handles    弱学习器回调函数集合
  */
-static inline void haar_ada_init(struct haar_adaboost *ada)
+static inline void haar_ada_init(struct haar_adaboost *ada, bool using_fold,
+				 const struct wl_handles *handles)
 {
 	ada->threshold = 0;
-	ada->using_fold = false;
-	link_list_init(&ada->wl);
+	ada->trace = NULL;
+	ada->using_fold = using_fold;
+	pack_array_init(&ada->wl, haar_wl_size(using_fold, handles));
 }
 
 /**
  * \brief 基于 Adaboost 的 Haar 特征选择器训练框架
  * \param[in] all_pass  当全部样本分类成功时执行的回调函数
+ * \param[in] using_fold 系数 alpha 是否并入弱学习器
  * \param[in] ada_hl    Adaboost 训练所需的回调函数集
  * \details \copydetails haar_ada_train_fn
  * \return 成功则返回真，且保存当前检测率到 *d，保存当前假阳率到 *f；否则返回假。
@@ -170,11 +185,12 @@ static inline bool train_framework(struct haar_adaboost *adaboost, flt_t * d,
 				   imgsz_t w, const sample_t * const X[],
 				   const sample_t * const X2[],
 				   const label_t Y[], all_pass_fn all_pass,
+				   bool using_fold,
 				   const struct wl_handles *handles,
 				   const struct ada_handles *ada_hl)
 {
 	struct train_setting st;
-	haar_ada_init(adaboost);
+	haar_ada_init(adaboost, using_fold, handles);
 	if (!init_setting(&st, adaboost, *d, *f, l, h, w, X, X2, Y, handles))
 		goto init_st_err;
 	switch (ada_framework(&st.ada, m, &st.sp, Y + l, ada_hl)) {
@@ -184,6 +200,8 @@ static inline bool train_framework(struct haar_adaboost *adaboost, flt_t * d,
 	case ADA_SUCCESS:
 		*d = st.ada.d;
 		*f = st.ada.f;
+		if (!set_trace(&st))
+			goto train_err;
 		break;
 	case ADA_FAILURE:
 deafult:
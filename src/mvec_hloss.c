@@ -119,10 +119,12 @@ static flt_t alpha_approx_wrap(const flt_t vals[], num_t vals_len, num_t m,
 static flt_t alpha_newton_wrap(const flt_t vals[], num_t vals_len, num_t m,
 			       const void *label, const flt_t D[]);
 /// 权重初始化方法
-static void init_D(flt_t D[], num_t m, const void *label);
+static void init_D(flt_t D[], num_t m, const void *label,
+		   const struct train_ctx *ctx);
 /// 权重更新方法
 static void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
-		     const void *label, flt_t alpha);
+		     const void *label, flt_t alpha,
+		     const struct train_ctx *ctx);
 
 /// 当全部样本分类成功时将被调用，参数 ada 将保存已训练的轮数
 /** （弱学习器系数不并入弱学习器）*/
@@ -153,9 +155,11 @@ static inline void free_label_wrap(struct label_wrap *lb);
  * \param[in] m         样本数量
  * \param[in] dim       不同标签的数量
  * \param[in] get_alpha 计算 alpha 的值（回调函数）
+ * \param[in] ctx       训练上下文，可为 NULL
  */
 static inline void ada_hl_init(struct ada_handles *handles, num_t m,
-			       mlabel_t dim, ada_alpha_fn get_alpha);
+			       mlabel_t dim, ada_alpha_fn get_alpha,
+			       const struct train_ctx *ctx);
 
 /**
  * \brief 输出数组最大值的索引
@@ -235,9 +239,15 @@ bool wl_train(void *weaklearner, num_t m, const void *sample,
 	unsigned char *wl_ptr = weaklearner;
 	const label_t *label_ptr = lb->labels;
 	const flt_t *D_ptr = D;
+	// 支持多标签训练时，各特征只扫描一次即得到所有分类的学习器
+	if (sp->handles->train_mvec != NULL)
+		return sp->handles->train_mvec(weaklearner, lb->dim, m, sp->n,
+					       sp->sample, lb->labels, D,
+					       sp->cache, sp->handles->ctx);
 	for (n = 0; n < lb->dim; ++n) {	// 分别对每种分类的学习器训练
 		if (!sp->handles->train.vec(wl_ptr, m, sp->n, sp->sample,
-					    label_ptr, D_ptr, sp->cache))
+					    label_ptr, D_ptr, sp->cache,
+					    sp->handles->ctx))
 			break;
 		wl_ptr += sp->handles->size;
 		label_ptr += m;
@@ -306,7 +316,8 @@ flt_t alpha_newton_wrap(const flt_t vals[], num_t vals_len, num_t m,
 	return alpha_newton(vals, vals_len, vals_len, lb->labels, D);
 }
 
-void init_D(flt_t D[], num_t m, const void *label)
+void init_D(flt_t D[], num_t m, const void *label,
+	    const struct train_ctx *ctx)
 {
 	const struct label_wrap *lb = label;
 	long_num_t n = lb->dim * m;
@@ -316,7 +327,7 @@ void init_D(flt_t D[], num_t m, const void *label)
 }
 
 void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
-	      const void *label, flt_t alpha)
+	      const void *label, flt_t alpha, const struct train_ctx *ctx)
 {
 	flt_t sum = 0;
 	const struct label_wrap *lb = label;
@@ -404,7 +415,7 @@ void free_label_wrap(struct label_wrap *lb)
 }
 
 void ada_hl_init(struct ada_handles *handles, num_t m, mlabel_t dim,
-		 ada_alpha_fn get_alpha)
+		 ada_alpha_fn get_alpha, const struct train_ctx *ctx)
 {
 	handles->D_len = m * dim;
 	handles->vals_len = m * dim;
@@ -414,6 +425,7 @@ void ada_hl_init(struct ada_handles *handles, num_t m, mlabel_t dim,
 	handles->next = wl_next;
 	handles->init_D = init_D;
 	handles->update_D = update_D;
+	handles->ctx = ctx;
 }
 
 mlabel_t argmax(flt_t output[], mlabel_t n)
@@ -444,7 +456,7 @@ bool train_framework(struct mvec_adaboost *adaboost, turn_t T, num_t m,
 		goto init_st_err;
 	if (!mvec_ada_init(adaboost, T, lb.dim, false, handles))
 		goto ada_init_err;
-	ada_hl_init(&ada_hl, m, lb.dim, get_alpha);
+	ada_hl_init(&ada_hl, m, lb.dim, get_alpha, handles->ctx);
 	switch (ada_framework(&st.ada, m, &st.sp, &lb, &ada_hl)) {
 	case ADA_FAILURE:
 		goto train_err;
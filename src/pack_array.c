@@ -0,0 +1,170 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pack_array.h"
+
+/**
+ * \file pack_array.c
+ * \brief 一个简单的紧凑数组实现 -- 函数实现
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-07-27
+ */
+/*******************************************************************************
+ * 				  静态函数声明
+ ******************************************************************************/
+/// 保证数组容量不小于 cap，成功则返回真，否则返回假
+static bool reserve (struct pack_array * arr, unsigned int cap);
+
+/*******************************************************************************
+ * 				    函数定义
+ ******************************************************************************/
+// 初始化操作
+void pack_array_init (struct pack_array * arr, size_t elem_size)
+{
+	const size_t align = _Alignof(max_align_t);
+	arr->data = NULL;
+	arr->stride = (elem_size + align - 1) / align * align;
+	arr->size = 0;
+	arr->cap = 0;
+}
+
+// 释放整个数组的内存空间
+void pack_array_free_full (struct pack_array * arr, void (*free_data) (void *))
+{
+	if (free_data != NULL)
+		pack_array_traverse (arr, free_data);
+	free (arr->data);
+	arr->data = NULL;
+	arr->size = 0;
+	arr->cap = 0;
+}
+
+// 追加元素到末尾
+void * pack_array_append (struct pack_array * arr)
+{
+	if (arr->size == arr->cap
+	    && !reserve (arr, (arr->cap == 0) ? 8 : arr->cap * 2))
+		return NULL;
+
+	void * elem = pack_array_get (arr, arr->size++);
+	memset (elem, 0, arr->stride);
+	return elem;
+}
+
+// 删除末尾元素
+void pack_array_pop_back (struct pack_array * arr)
+{
+	--arr->size;
+}
+
+// 删除所有元素，保留容量
+void pack_array_clear (struct pack_array * arr)
+{
+	arr->size = 0;
+}
+
+// 写入数组到文件
+bool pack_array_write (const struct pack_array * arr, FILE * file,
+		bool (*write_data) (const void *, va_list, FILE *), ...)
+{
+	if (write_data == NULL)
+		return false;
+	if (fwrite (&arr->size, sizeof(unsigned int), 1, file) < 1)
+		return false;
+
+	va_list ap;
+	for (unsigned int i = 0; i < arr->size; ++i) {
+		va_start (ap, write_data);
+		if (! write_data (pack_array_get (arr, i), ap, file)) {
+			va_end (ap);
+			return false;
+		}
+		va_end (ap);
+	}
+
+	return true;
+}
+
+bool pack_array_read (struct pack_array * arr, FILE * file,
+		bool (*read_data) (void *, va_list, FILE *), ...)
+{
+	unsigned int tmp_size;
+	if (read_data == NULL)
+		return false;
+
+	if (fread (&tmp_size, sizeof(unsigned int), 1, file) < 1)
+		return false;
+	if (! reserve (arr, arr->size + tmp_size))
+		return false;
+
+	va_list ap;
+	for (unsigned int i = 0; i < tmp_size; ++i) {
+		void * elem = pack_array_append (arr);
+		va_start (ap, read_data);
+		if (! read_data (elem, ap, file)) {
+			va_end (ap);
+			pack_array_pop_back (arr);
+			return false;
+		}
+		va_end (ap);
+	}
+
+	return true;
+}
+
+struct pack_array * pack_array_copy_full (struct pack_array * tgt,
+		const struct pack_array * src,
+		bool (*copy_data) (void *, const void *, va_list), ...)
+{
+	if (copy_data == NULL)
+		return NULL;
+	if (! reserve (tgt, tgt->size + src->size))
+		return NULL;
+
+	va_list ap;
+	for (unsigned int i = 0; i < src->size; ++i) {
+		void * elem = pack_array_append (tgt);
+		va_start (ap, copy_data);
+		if (! copy_data (elem, pack_array_get (src, i), ap)) {
+			va_end (ap);
+			pack_array_pop_back (tgt);
+			return NULL;
+		}
+		va_end (ap);
+	}
+	return tgt;
+}
+
+void pack_array_traverse (struct pack_array *arr, void (*fun) (void *))
+{
+	for (unsigned int i = 0; i < arr->size; ++i)
+		fun (pack_array_get (arr, i));
+}
+
+void pack_array_traverse_r (struct pack_array *arr,
+		void (*fun) (void *, va_list), ...)
+{
+	va_list ap;
+	for (unsigned int i = 0; i < arr->size; ++i) {
+		va_start (ap, fun);
+		fun (pack_array_get (arr, i), ap);
+		va_end (ap);
+	}
+}
+
+/*******************************************************************************
+ * 				  静态函数定义
+ ******************************************************************************/
+bool reserve (struct pack_array * arr, unsigned int cap)
+{
+	if (cap <= arr->cap)
+		return true;
+
+	void * ptr = realloc (arr->data, arr->stride * cap);
+	if (ptr == NULL)
+		return false;
+	arr->data = ptr;
+	arr->cap = cap;
+	return true;
+}
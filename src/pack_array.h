@@ -0,0 +1,154 @@
+#ifndef PACK_ARRAY_H
+#define PACK_ARRAY_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+/**
+ * \file pack_array.h
+ * \brief 一个简单的紧凑数组实现（元素定长、连续存放、可增长） -- 函数声明。
+ * 	读写、复制、释放接口与 link_list 一致，文件格式与 link_list 相同
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-07-27
+ */
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/// 紧凑数组结构体
+struct pack_array {
+	unsigned char *data;		///< 元素数组
+	size_t stride;			///< 单个元素占用的长度（字节，按 max_align_t
+					/**< 对齐），元素可直接存放任意类型 */
+	unsigned int size;		///< 数组长度
+	unsigned int cap;		///< 数组容量
+};
+
+/*******************************************************************************
+ * 				    函数原型
+ ******************************************************************************/
+/**
+ * \brief 数组初始化操作（不申请内存）
+ * \param[out] arr      未初始化数组地址，函数执行后数组被初始化
+ * \param[in] elem_size 单个元素的长度（字节）
+ */
+void pack_array_init (struct pack_array * arr, size_t elem_size);
+
+/**
+ * \brief 释放整个数组的内存空间
+ * \param[out] arr      指向已初始化的数组
+ * \param[in] free_data 用于释放元素内部资源的回调函数（不释放元素本身），
+ * 	可以为 NULL
+ */
+void pack_array_free_full (struct pack_array * arr, void (*free_data) (void *));
+
+/**
+ * \brief 在数组末尾追加一个元素
+ * \param[in, out] arr 指向已初始化的数组
+ * \return 成功则返回新元素的地址（内容已清零），否则返回 NULL。
+ * 	注：数组扩容后，先前获取的元素地址失效
+ */
+void * pack_array_append (struct pack_array * arr);
+
+/**
+ * \brief 删除数组末尾的元素（不释放元素内部资源）
+ * \param[in, out] arr 指向已初始化的非空数组
+ */
+void pack_array_pop_back (struct pack_array * arr);
+
+/**
+ * \brief 删除数组的所有元素（不释放元素内部资源），保留已申请的容量
+ * \param[in, out] arr 指向已初始化的数组
+ */
+void pack_array_clear (struct pack_array * arr);
+
+/**
+ * \brief 写入数组到文件
+ * \param[in] arr         已初始化的数组
+ * \param[out] file       用于保存数组的文件指针
+ * \param[in] write_data  回调函数，负责将元素（第一个参数）的内容写入文件；成功
+ *                        则返回真，否则返回假。
+ * \param[in, out] ...    可变参数，将被传递给 write_data() 函数，用于实现可重入性
+ * \return 写入成功则返回真，否则返回假
+ */
+bool pack_array_write (const struct pack_array * arr, FILE * file,
+		bool (*write_data) (const void *, va_list, FILE *), ...);
+
+/**
+ * \brief 从文件读取数组
+ * \param[out] arr      已初始化的空数组
+ * \param[in] file      保存有数组数据的文件指针
+ * \param[in] read_data 回调函数，从文件读取单个元素到第一个参数所指向的位置；
+ *                      成功则返回真，否则返回假
+ * \param[in] ...       可变参数，将被传递给 read_data() 函数，用于实现可重入性
+ * \return 读取成功则返回真，否则返回假（已读取的元素仍保留在数组中）
+ */
+bool pack_array_read (struct pack_array * arr, FILE * file,
+		bool (*read_data) (void *, va_list, FILE *), ...);
+
+/**
+ * \brief 对数组执行深度复制
+ * \param[out] tgt      已初始化但为空的数组（目标数组），元素长度与 src 相同
+ * \param[in] src       已初始化的数组（源数组）
+ * \param[in] copy_data 回调函数，将单个元素（第二个参数）复制到第一个参数所指向
+ *                      的位置；成功则返回真，否则返回假
+ * \param[in] ...       可变参数，将被传递给 copy_data() 函数，用于实现可重入性
+ * \return 复制成功则返回 tgt，否则返回 NULL（已复制的元素仍保留在数组中）
+ */
+struct pack_array * pack_array_copy_full (struct pack_array * tgt,
+		const struct pack_array * src,
+		bool (*copy_data) (void *, const void *, va_list), ...);
+
+/**
+ * \brief 遍历数组并修改数组元素
+ * \param[in, out] arr 已初始化的数组
+ * \param[in] fun      回调函数，对于数组的每个元素，都将作为参数传递给 fun()
+ */
+void pack_array_traverse (struct pack_array *arr, void (*fun) (void *));
+
+/**
+ * \brief pack_array_traverse 的可重入版本，遍历数组并修改数组元素
+ * \param[in, out] arr 已初始化的数组
+ * \param[in] fun      回调函数，对于数组的每个元素，都将作为参数传递给 fun()
+ * \param[in, out] ... 可变参数，将被传递给 fun() 函数，用于实现可重入性
+ */
+void pack_array_traverse_r (struct pack_array *arr,
+		void (*fun) (void *, va_list), ...);
+
+/*******************************************************************************
+ * 				  内联函数实现
+ ******************************************************************************/
+/**
+ * \brief 获取数组元素个数
+ * \param[in] arr 已初始化的数组
+ * \return 返回数组当前元素个数
+ */
+static inline unsigned int pack_array_size (const struct pack_array *arr)
+{
+	return arr->size;
+}
+
+/**
+ * \brief 获取数组元素
+ * \param[in] arr 已初始化的数组
+ * \param[in] i   元素索引（小于数组长度）
+ * \return 返回第 i 个元素的地址
+ */
+static inline void * pack_array_get (const struct pack_array *arr,
+				     unsigned int i)
+{
+	return arr->data + arr->stride * i;
+}
+
+/**
+ * \brief 获取数组最后一个元素
+ * \param[in] arr 已初始化的非空数组
+ * \return 返回最后一个元素的地址
+ */
+static inline void * pack_array_back (const struct pack_array *arr)
+{
+	return pack_array_get (arr, arr->size - 1);
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include "train_ctx.h"
+
+/**
+ * \file train_ctx.c
+ * \brief 训练上下文 -- 函数实现
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-08-05
+ */
+/*******************************************************************************
+ * 				    全局变量
+ ******************************************************************************/
+// 随机数状态为 train_ctx_init(&ctx, 0) 的结果
+struct train_ctx train_ctx_default = {
+	.s = { 0xe220a8397b1dcdafULL, 0x6e789e6aa1b965f4ULL,
+	       0x06c45d188009454fULL, 0xf88bb8a8724c81ecULL },
+	.asym_const = ASYM_CONST,
+	.asym_turn = ASYM_TURN,
+	.seg_interval = VEC_SEG_INTERVAL,
+	.min_interval = MIN_INTERVAL,
+};
+
+/*******************************************************************************
+ * 				  静态函数声明
+ ******************************************************************************/
+/**
+ * \brief splitmix64：以 *x 为计数器产生下一个 64 位随机数，用于扩展种子
+ * \param[in, out] x 计数器
+ * \return 返回随机数
+ */
+static uint64_t splitmix64(uint64_t *x);
+
+/*******************************************************************************
+ * 				    函数定义
+ ******************************************************************************/
+void train_ctx_init(struct train_ctx *ctx, uint64_t seed)
+{
+	for (int i = 0; i < 4; ++i)
+		ctx->s[i] = splitmix64(&seed);
+	ctx->asym_const = ASYM_CONST;
+	ctx->asym_turn = ASYM_TURN;
+	ctx->seg_interval = VEC_SEG_INTERVAL;
+	ctx->min_interval = MIN_INTERVAL;
+	ctx->stream = NULL;
+	ctx->stream_arg = NULL;
+}
+
+void train_ctx_derive(struct train_ctx *dst, const struct train_ctx *src,
+		      uint64_t key, uint64_t id)
+{
+	// 先将 id 打散再与 key 组合，相邻的 id 得到不相关的计数器起点
+	uint64_t x = id;
+	x = key ^ splitmix64(&x);
+	*dst = (src == NULL) ? train_ctx_default : *src;
+	for (int i = 0; i < 4; ++i)
+		dst->s[i] = splitmix64(&x);
+	// 子上下文通常交给其他线程，不共用样本访问提示
+	dst->stream = NULL;
+	dst->stream_arg = NULL;
+}
+
+/*******************************************************************************
+ * 				  静态函数实现
+ ******************************************************************************/
+uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
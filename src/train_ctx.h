@@ -0,0 +1,158 @@
+#ifndef TRAIN_CTX_H
+#define TRAIN_CTX_H
+#include <stdint.h>
+#include <stdlib.h>
+#include "boost_cfg.h"
+/**
+ * \file train_ctx.h
+ * \brief 训练上下文 -- 类型定义及函数声明。
+ * 	训练上下文保存一次训练所用的随机数状态及可调参数，由弱学习器回调函数集
+ * 	（struct wl_handles 的 ctx 字段）传递给 Adaboost 训练框架及弱学习器。
+ * 	各训练使用各自的上下文时互不影响，可在同一进程中并行训练多个模型；上下文
+ * 	为 NULL 时使用默认上下文 train_ctx_default（非线程安全）。
+ * 	随机数发生器为 xoshiro256**（不加锁，周期 2^256 - 1），可用
+ * 	train_ctx_derive() 按任务编号派生互不相关的子上下文，分配给不同线程后
+ * 	结果与执行次序无关
+ * \author Shuojia
+ * \version 1.0
+ * \date 2024-08-05
+ */
+/*******************************************************************************
+ * 				    宏定义
+ ******************************************************************************/
+/// 顺序扫描样本时，每隔多少个样本调用一次样本访问提示
+#define TRAIN_STREAM_CHUNK 256
+
+/*******************************************************************************
+ * 				    类型定义
+ ******************************************************************************/
+/**
+ * \brief 样本访问提示函数：训练即将按顺序读取积分图 x 及其后的样本
+ * \param[in] arg 即 train_ctx 的 stream_arg 字段
+ * \param[in] x   即将读取的样本的积分图地址
+ */
+typedef void (*train_stream_fn)(void *arg, const void *x);
+
+/// 训练上下文
+struct train_ctx {
+	uint64_t s[4];		///< 随机数状态（xoshiro256**），不能全为 0
+	flt_t asym_const;	///< 非对称损失倍数，默认为 ASYM_CONST
+	num_t asym_turn;	///< 非对称损失分摊的轮数，默认为 ASYM_TURN
+	flt_t seg_interval;	///< 划分值与特征值的间隔，默认为 VEC_SEG_INTERVAL
+	flt_t min_interval;	///< 阈值与验证集输出的间隔，默认为 MIN_INTERVAL
+	train_stream_fn stream;	///< 样本访问提示，默认为 NULL（不提示）
+	void *stream_arg;	///< stream 的参数
+};
+
+/*******************************************************************************
+ * 				    全局变量
+ ******************************************************************************/
+/// 默认训练上下文（种子为 0），上下文为 NULL 时使用；可用 train_ctx_init() 重设
+extern struct train_ctx train_ctx_default;
+
+/*******************************************************************************
+ * 				    函数声明
+ ******************************************************************************/
+/**
+ * \brief 初始化训练上下文，参数取 boost_cfg.h 中的默认设置
+ * \param[out] ctx 未初始化的训练上下文
+ * \param[in] seed 随机数种子（经 splitmix64 扩展为随机数状态）
+ */
+void train_ctx_init(struct train_ctx *ctx, uint64_t seed);
+
+/**
+ * \brief 派生子上下文：参数与 src 相同（不含样本访问提示），随机数状态只由
+ * 	key 与 id 决定（计数器方式，不改变 src）。同一 key 下各 id 的子上下文
+ * 	互不相关，任务 id 无论由哪个线程、以何种次序执行，所得随机数序列都相同
+ * \param[out] dst 用于保存子上下文
+ * \param[in] src  父上下文，为 NULL 时使用默认上下文
+ * \param[in] key  派生密钥，通常由父上下文产生一次（train_next()）
+ * \param[in] id   任务编号
+ */
+void train_ctx_derive(struct train_ctx *dst, const struct train_ctx *src,
+		      uint64_t key, uint64_t id);
+
+/*******************************************************************************
+ * 				  内联函数实现
+ ******************************************************************************/
+/// 上下文为 NULL 时返回默认上下文
+static inline struct train_ctx *train_ctx_get(struct train_ctx *ctx)
+{
+	return (ctx == NULL) ? &train_ctx_default : ctx;
+}
+
+/**
+ * \brief 产生 64 位随机数（xoshiro256**）
+ * \param[in, out] ctx 训练上下文，为 NULL 时使用默认上下文
+ * \return 返回均匀分布的 64 位随机数
+ */
+static inline uint64_t train_next(struct train_ctx *ctx)
+{
+	uint64_t *s = train_ctx_get(ctx)->s;
+	uint64_t x = s[1] * 5;
+	uint64_t r = ((x << 7) | (x >> 57)) * 9;
+	uint64_t t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = (s[3] << 45) | (s[3] >> 19);
+	return r;
+}
+
+/**
+ * \brief 产生与 rand() 取值范围相同的随机数
+ * \param[in, out] ctx 训练上下文，为 NULL 时使用默认上下文
+ * \return 返回 [0, RAND_MAX] 内的随机数
+ */
+static inline int train_rand(struct train_ctx *ctx)
+{
+	return (train_next(ctx) >> 11) % ((uint64_t) RAND_MAX + 1);
+}
+
+/**
+ * \brief 顺序扫描样本时的访问提示：每 TRAIN_STREAM_CHUNK 个样本调用一次
+ * 	ctx->stream（如由样本存储按块换入换出样本）
+ * \param[in] ctx 训练上下文，为 NULL 时使用默认上下文
+ * \param[in] i   样本在本次扫描中的下标
+ * \param[in] x   第 i 个样本的积分图地址
+ */
+static inline void train_stream(const struct train_ctx *ctx, num_t i,
+				const void *x)
+{
+	if (i % TRAIN_STREAM_CHUNK != 0)
+		return;
+	if (ctx == NULL)
+		ctx = &train_ctx_default;
+	if (ctx->stream != NULL)
+		ctx->stream(ctx->stream_arg, x);
+}
+
+/// 非对称损失倍数
+static inline flt_t train_asym_const(const struct train_ctx *ctx)
+{
+	return (ctx == NULL) ? train_ctx_default.asym_const : ctx->asym_const;
+}
+
+/// 非对称损失分摊的轮数
+static inline num_t train_asym_turn(const struct train_ctx *ctx)
+{
+	return (ctx == NULL) ? train_ctx_default.asym_turn : ctx->asym_turn;
+}
+
+/// 划分值与特征值的间隔
+static inline flt_t train_seg_interval(const struct train_ctx *ctx)
+{
+	return (ctx == NULL) ? train_ctx_default.seg_interval :
+	    ctx->seg_interval;
+}
+
+/// 阈值与验证集输出的间隔
+static inline flt_t train_min_interval(const struct train_ctx *ctx)
+{
+	return (ctx == NULL) ? train_ctx_default.min_interval :
+	    ctx->min_interval;
+}
+
+#endif
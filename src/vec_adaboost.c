@@ -26,10 +26,12 @@ static enum ada_result get_vals(flt_t vals[], num_t vals_len,
 				const void *sample, const void *label,
 				const flt_t D[]);
 /// 初始化概率分布数组
-static void init_D(flt_t D[], num_t m, const void *label);
+static void init_D(flt_t D[], num_t m, const void *label,
+		   const struct train_ctx *ctx);
 /// 更新概率分布数组
 static void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
-		     const void *label, flt_t alpha);
+		     const void *label, flt_t alpha,
+		     const struct train_ctx *ctx);
 
 /**
  * \brief 初始化 Adaboost 回调函数集
@@ -39,10 +41,12 @@ static void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
  * \param[in] get_vals  计算中间值 Y[i] * h_t(x[i]) 并保存到数组中，见 adaboost_base.h 说明
  * \param[in] get_alpha 计算 alpha 的值，可为 AlphaCalc/alpha.h 中的函数
  * \param[in] next      函数指针，用于获取下一轮弱学习器及其系数的地址，见 adaboost_base.h 说明
+ * \param[in] ctx       训练上下文，可为 NULL
  */
 static inline void ada_hl_init(struct ada_handles *handles, num_t m,
 			       ada_train_fn train, ada_vals_fn get_vals,
-			       ada_alpha_fn get_alpha, ada_next_fn next);
+			       ada_alpha_fn get_alpha, ada_next_fn next,
+			       const struct train_ctx *ctx);
 
 /**
  * \brief 初始化 Adaboost
@@ -222,7 +226,7 @@ bool wl_train(void *weaklearner, num_t m, const void *sample,
 {
 	const struct sp_wrap *sp = sample;
 	return sp->handles->train.vec(weaklearner, m, sp->n, sp->sample, label,
-				      D, sp->cache);
+				      D, sp->cache, sp->handles->ctx);
 }
 
 bool wl_next(struct ada_item *item, void *adaboost, const flt_t vals[],
@@ -269,7 +273,8 @@ enum ada_result get_vals(flt_t vals[], num_t vals_len, const void *weaklearner,
 		return ADA_SUCCESS;
 }
 
-void init_D(flt_t D[], num_t m, const void *label)
+void init_D(flt_t D[], num_t m, const void *label,
+	    const struct train_ctx *ctx)
 {
 	flt_t val = (flt_t) 1.0 / m;
 	for (num_t i = 0; i < m; ++i)
@@ -277,7 +282,7 @@ void init_D(flt_t D[], num_t m, const void *label)
 }
 
 void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
-	      const void *label, flt_t alpha)
+	      const void *label, flt_t alpha, const struct train_ctx *ctx)
 {
 	num_t i;
 	flt_t Z = 0;
@@ -292,7 +297,8 @@ void update_D(flt_t D[], flt_t vals[], num_t vals_len, num_t m,
 }
 
 void ada_hl_init(struct ada_handles *handles, num_t m, ada_train_fn train,
-		 ada_vals_fn get_vals, ada_alpha_fn get_alpha, ada_next_fn next)
+		 ada_vals_fn get_vals, ada_alpha_fn get_alpha, ada_next_fn next,
+		 const struct train_ctx *ctx)
 {
 	handles->D_len = m;
 	handles->vals_len = m;
@@ -302,6 +308,7 @@ void ada_hl_init(struct ada_handles *handles, num_t m, ada_train_fn train,
 	handles->next = next;
 	handles->init_D = init_D;
 	handles->update_D = update_D;
+	handles->ctx = ctx;
 }
 
 bool vec_ada_init(struct vec_adaboost *ada, turn_t T, bool using_fold,
@@ -360,7 +367,8 @@ bool train_framework(struct vec_adaboost *adaboost, turn_t T, num_t m,
 {
 	struct ada_handles ada_hl;
 	struct train_setting st;
-	ada_hl_init(&ada_hl, m, wl_train, get_vals, get_alpha, wl_next);
+	ada_hl_init(&ada_hl, m, wl_train, get_vals, get_alpha, wl_next,
+		    handles->ctx);
 	if (!init_setting(&st, adaboost, m, n, X, cache_on, handles))
 		return false;
 	if (!vec_ada_init(adaboost, T, false, handles))